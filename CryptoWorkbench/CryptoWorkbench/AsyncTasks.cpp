@@ -0,0 +1,220 @@
+#include "AsyncTasks.h"
+#include <QRunnable>
+#include <QMutexLocker>
+#include "WorkbenchEngine.h"
+#include "Utility.h"
+
+using namespace v8;
+
+
+class AsyncTasks::Runner : public QRunnable
+{
+public:
+	Runner(AsyncTasks* asyncTasks, Task* runnerTask, int runGeneration)
+		: tasks(asyncTasks), task(runnerTask), generation(runGeneration), isSucceeded(false)
+	{
+		// Runner is deleted on isolate thread after its promise is settled
+		setAutoDelete(false);
+	}
+
+	~Runner()
+	{
+		delete task;
+	}
+
+	virtual void run()
+	{
+		isSucceeded = task->run(&errorMessage);
+
+		QMutexLocker locker(&tasks->mutex);
+		tasks->finishedRunners.append(this);
+		tasks->finishedCondition.wakeAll();
+	}
+
+	AsyncTasks* tasks;
+	Task* task;
+	int generation;
+	bool isSucceeded;
+	QString errorMessage;
+	Global<Promise::Resolver> resolver;
+};
+
+
+AsyncTasks::AsyncTasks(int threadCount)
+	: isInterrupted(0), pendingTasks(0), generation(0), awaitId(0), isAwaitSettled(false), isAwaitRejected(false)
+{
+	if (threadCount > 0)
+		threadPool.setMaxThreadCount(threadCount);
+}
+
+AsyncTasks::~AsyncTasks()
+{
+	// Runners still hold resolvers, they are released only after pool threads are done with them
+	threadPool.waitForDone();
+	qDeleteAll(finishedRunners);
+}
+
+AsyncTasks* AsyncTasks::current(Isolate* isolate)
+{
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(isolate->GetData(Utility::DataSlotEngine));
+	return workbenchEngine->asyncTasks();
+}
+
+Local<Promise> AsyncTasks::start(Isolate* isolate, Task* task)
+{
+	EscapableHandleScope handle_scope(isolate);
+
+	Local<Promise::Resolver> resolver;
+	if (!Promise::Resolver::New(isolate->GetCurrentContext()).ToLocal(&resolver)) {
+		delete task;
+		return Local<Promise>();
+	}
+
+	Runner* runner = new Runner(this, task, generation);
+	runner->resolver.Reset(isolate, resolver);
+	pendingTasks++;
+	threadPool.start(runner);
+
+	return handle_scope.Escape(resolver->GetPromise());
+}
+
+bool AsyncTasks::pump(Isolate* isolate)
+{
+	HandleScope handle_scope(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+
+	// Callbacks queued by script itself run before anything is awaited
+	isolate->RunMicrotasks();
+
+	while (true) {
+		QList<Runner*> runners;
+		{
+			QMutexLocker locker(&mutex);
+			while (finishedRunners.isEmpty() && pendingTasks > 0 && !isInterrupted.load())
+				finishedCondition.wait(&mutex);
+
+			if (isInterrupted.load())
+				return false;
+			if (finishedRunners.isEmpty())
+				return true;
+			runners.swap(finishedRunners);
+		}
+
+		// Every promise is settled in its own scope, microtasks run after each batch
+		bool isSettled = true;
+		for (int i = 0; i < runners.count(); i++) {
+			Runner* runner = runners.at(i);
+			if (runner->generation == generation && isSettled) {
+				HandleScope handle_scope(isolate);
+				pendingTasks--;
+
+				Local<Promise::Resolver> resolver = Local<Promise::Resolver>::New(isolate, runner->resolver);
+				Local<Value> value;
+				if (runner->isSucceeded)
+					value = runner->task->result(isolate);
+
+				if (!value.IsEmpty()) {
+					isSettled = !resolver->Resolve(context, value).IsNothing();
+				}
+				else {
+					QString message = runner->isSucceeded ? QString("Could not convert result of async task") : runner->errorMessage;
+					isSettled = !resolver->Reject(context, Exception::Error(Utility::toV8String(isolate, message))).IsNothing();
+				}
+			}
+			delete runner;
+		}
+
+		// Settling fails only when script is being terminated
+		if (!isSettled)
+			return false;
+
+		isolate->RunMicrotasks();
+	}
+}
+
+bool AsyncTasks::await(Isolate* isolate, Local<Value>* value, QString* errorMessage)
+{
+	EscapableHandleScope handle_scope(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+
+	// Result of the script is known only after its promise settles
+	// Persistent context may settle the promise in later run, reactions carry only id of this call
+	awaitId++;
+	settledValue.Reset();
+	isAwaitSettled = false;
+	isAwaitRejected = false;
+	if ((*value)->IsPromise()) {
+		Local<Promise> promise = Local<Promise>::Cast(*value);
+		Local<Integer> data = Integer::New(isolate, awaitId);
+
+		Local<Function> onFulfilled;
+		Local<Function> onRejected;
+		if (!Function::New(context, fulfilledCallback, data).ToLocal(&onFulfilled) ||
+			!Function::New(context, rejectedCallback, data).ToLocal(&onRejected) ||
+			promise->Then(context, onFulfilled).IsEmpty() ||
+			promise->Catch(context, onRejected).IsEmpty()) {
+			*errorMessage = "Could not wait for promise";
+			return false;
+		}
+	}
+
+	if (!pump(isolate)) {
+		*errorMessage = "Script execution stopped";
+		return false;
+	}
+
+	if (!(*value)->IsPromise())
+		return true;
+
+	if (!isAwaitSettled) {
+		*errorMessage = "Promise returned by script was never settled";
+		return false;
+	}
+
+	Local<Value> settlement = Local<Value>::New(isolate, settledValue);
+	settledValue.Reset();
+	if (isAwaitRejected) {
+		*errorMessage = QString("Uncaught (in promise) %1").arg(Utility::toString(settlement));
+		return false;
+	}
+
+	*value = handle_scope.Escape(settlement);
+	return true;
+}
+
+void AsyncTasks::fulfilledCallback(const FunctionCallbackInfo<Value>& args)
+{
+	current(args.GetIsolate())->settle(args, false);
+}
+
+void AsyncTasks::rejectedCallback(const FunctionCallbackInfo<Value>& args)
+{
+	current(args.GetIsolate())->settle(args, true);
+}
+
+void AsyncTasks::settle(const FunctionCallbackInfo<Value>& args, bool isRejected)
+{
+	// Promise awaited by earlier run settled late, nobody waits for it any more
+	if (Local<Integer>::Cast(args.Data())->Value() != awaitId)
+		return;
+
+	settledValue.Reset(args.GetIsolate(), args[0]);
+	isAwaitSettled = true;
+	isAwaitRejected = isRejected;
+}
+
+void AsyncTasks::interrupt()
+{
+	QMutexLocker locker(&mutex);
+	isInterrupted.store(1);
+	finishedCondition.wakeAll();
+}
+
+void AsyncTasks::cancelPending()
+{
+	// Runners of earlier generations are dropped by pump() when they finish
+	QMutexLocker locker(&mutex);
+	generation++;
+	pendingTasks = 0;
+	isInterrupted.store(0);
+}
@@ -0,0 +1,89 @@
+#ifndef ASYNCTASKS_H
+#define ASYNCTASKS_H
+
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include "include/v8.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Work of async natives running on native thread pool. Every task is bound
+/// to a promise, finished tasks are delivered back on isolate thread by pump(),
+/// which settles their promises and runs microtasks waiting for them.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class AsyncTasks
+{
+	class Runner;
+
+public:
+	// Work started by async native
+	class Task
+	{
+	public:
+		virtual ~Task() {}
+
+		// Heavy part of the task, called on pool thread and must not touch V8
+		// Returns false with errorMessage set on failure
+		virtual bool run(QString* errorMessage) = 0;
+
+		// Value the promise is resolved with, called on isolate thread inside context
+		virtual v8::Local<v8::Value> result(v8::Isolate* isolate) = 0;
+	};
+
+	// Pool threads, 0 for one per processor core
+	AsyncTasks(int threadCount);
+
+	// Waits for running tasks, must be called with isolate locked
+	~AsyncTasks();
+
+	// Tasks of engine owning the isolate
+	static AsyncTasks* current(v8::Isolate* isolate);
+
+	// Queue task on pool and return promise settled by pump(), task is owned by AsyncTasks
+	// Returns empty handle when promise cannot be created
+	v8::Local<v8::Promise> start(v8::Isolate* isolate, Task* task);
+
+	// Settle promises of finished tasks and run microtasks until no task of current run is pending
+	// Returns false when interrupted
+	bool pump(v8::Isolate* isolate);
+
+	// Pump tasks and replace promise with its value, other values are kept
+	// Returns false with errorMessage set when promise is rejected, never settled or pump is interrupted
+	bool await(v8::Isolate* isolate, v8::Local<v8::Value>* value, QString* errorMessage);
+
+	// Stop waiting in pump(), can be called from any thread
+	void interrupt();
+
+	// Start new run, promises of tasks started earlier are never settled
+	void cancelPending();
+
+private:
+	// Reactions attached by await(), they outlive the call when script keeps the promise
+	static void fulfilledCallback(const v8::FunctionCallbackInfo<v8::Value>& args);
+	static void rejectedCallback(const v8::FunctionCallbackInfo<v8::Value>& args);
+	void settle(const v8::FunctionCallbackInfo<v8::Value>& args, bool isRejected);
+
+private:
+	QThreadPool threadPool;
+	QMutex mutex;
+	QWaitCondition finishedCondition;
+	QList<Runner*> finishedRunners;
+	QAtomicInt isInterrupted;
+	int pendingTasks;
+	int generation;
+
+	// Settlement of promise awaited by the last await(), reactions of earlier calls are ignored
+	int awaitId;
+	v8::Global<v8::Value> settledValue;
+	bool isAwaitSettled;
+	bool isAwaitRejected;
+
+	Q_DISABLE_COPY(AsyncTasks)
+};
+
+#endif // ASYNCTASKS_H
@@ -0,0 +1,183 @@
+#include "BatchDialog.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFormLayout>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QSpinBox>
+#include <QProgressBar>
+#include <QLabel>
+#include <QPushButton>
+#include <QFileDialog>
+#include <QThread>
+
+// Items of output mode combo box
+enum OutputMode
+{
+	OutputJsonLines,
+	OutputDirectory,
+};
+
+
+BatchDialog::BatchDialog(const Environment& engineEnvironment, const QString& script, QWidget* parent)
+	: QDialog(parent), environment(engineEnvironment), scriptText(script), runner(NULL)
+{
+	setWindowTitle("Batch Run");
+	setMinimumWidth(500);
+
+	QVBoxLayout* layout = new QVBoxLayout(this);
+	QFormLayout* formLayout = new QFormLayout();
+
+	QHBoxLayout* inputLayout = new QHBoxLayout();
+	inputEdit = new QLineEdit(this);
+	inputEdit->setPlaceholderText("../data/captures/*.txt");
+	QPushButton* buttonBrowseInput = new QPushButton("...", this);
+	connect(buttonBrowseInput, &QPushButton::clicked, this, &BatchDialog::browseInputClicked);
+	inputLayout->addWidget(inputEdit);
+	inputLayout->addWidget(buttonBrowseInput);
+	formLayout->addRow("Input files", inputLayout);
+
+	QHBoxLayout* outputLayout = new QHBoxLayout();
+	outputModeCombo = new QComboBox(this);
+	outputModeCombo->addItem("JSON lines file");
+	outputModeCombo->addItem("Directory");
+	outputEdit = new QLineEdit(this);
+	QPushButton* buttonBrowseOutput = new QPushButton("...", this);
+	connect(buttonBrowseOutput, &QPushButton::clicked, this, &BatchDialog::browseOutputClicked);
+	outputLayout->addWidget(outputModeCombo);
+	outputLayout->addWidget(outputEdit);
+	outputLayout->addWidget(buttonBrowseOutput);
+	formLayout->addRow("Output", outputLayout);
+
+	engineCountSpin = new QSpinBox(this);
+	engineCountSpin->setRange(1, 64);
+	engineCountSpin->setValue(QThread::idealThreadCount());
+	formLayout->addRow("Engines", engineCountSpin);
+
+	progressBar = new QProgressBar(this);
+	progressBar->setRange(0, 1);
+	progressBar->setValue(0);
+	statusLabel = new QLabel(this);
+
+	QHBoxLayout* buttonLayout = new QHBoxLayout();
+	buttonStart = new QPushButton("&Start", this);
+	buttonStart->setMinimumHeight(30);
+	connect(buttonStart, &QPushButton::clicked, this, &BatchDialog::startClicked);
+	buttonCancel = new QPushButton("&Close", this);
+	buttonCancel->setMinimumHeight(30);
+	connect(buttonCancel, &QPushButton::clicked, this, &BatchDialog::cancelClicked);
+	buttonLayout->addStretch(1);
+	buttonLayout->addWidget(buttonStart);
+	buttonLayout->addWidget(buttonCancel);
+
+	layout->addLayout(formLayout);
+	layout->addWidget(progressBar);
+	layout->addWidget(statusLabel);
+	layout->addLayout(buttonLayout);
+
+	batchThread = new QThread(this);
+	batchThread->start();
+}
+
+BatchDialog::~BatchDialog()
+{
+	if (runner != NULL)
+		runner->cancel();
+
+	batchThread->quit();
+	batchThread->wait();
+	delete runner;
+}
+
+void BatchDialog::browseInputClicked()
+{
+	QString directory = QFileDialog::getExistingDirectory(this, tr("Input Directory"), "../data/");
+	if (!directory.isEmpty())
+		inputEdit->setText(directory + "/*");
+}
+
+void BatchDialog::browseOutputClicked()
+{
+	QString path;
+	if (outputModeCombo->currentIndex() == OutputDirectory)
+		path = QFileDialog::getExistingDirectory(this, tr("Output Directory"), "../data/");
+	else
+		path = QFileDialog::getSaveFileName(this, tr("Output File"), "../data/", tr("JSON Lines (*.jsonl)"));
+
+	if (!path.isEmpty())
+		outputEdit->setText(path);
+}
+
+void BatchDialog::startClicked()
+{
+	if (runner != NULL)
+		return;
+
+	QStringList files = BatchRunner::expandGlob(inputEdit->text());
+	if (files.isEmpty()) {
+		statusLabel->setText("No input files");
+		return;
+	}
+	if (outputEdit->text().isEmpty()) {
+		statusLabel->setText("Output is not set");
+		return;
+	}
+
+	// Runner with its engines lives on batch thread for the duration of one batch
+	runner = new BatchRunner(environment, engineCountSpin->value());
+	runner->moveToThread(batchThread);
+	connect(this, &BatchDialog::runRequested, runner, &BatchRunner::run);
+	connect(runner, &BatchRunner::progress, this, &BatchDialog::batchProgress);
+	connect(runner, &BatchRunner::finished, this, &BatchDialog::batchFinished);
+	connect(runner, &BatchRunner::failed, this, &BatchDialog::batchFailed);
+
+	progressBar->setRange(0, files.count());
+	progressBar->setValue(0);
+	statusLabel->setText(QString("Running %1 files...").arg(files.count()));
+	setRunning(true);
+
+	emit runRequested(scriptText, files, outputEdit->text(), outputModeCombo->currentIndex() == OutputJsonLines);
+}
+
+void BatchDialog::cancelClicked()
+{
+	if (runner != NULL)
+		runner->cancel();
+	else
+		reject();
+}
+
+void BatchDialog::batchProgress(int finishedCount, int fileCount)
+{
+	progressBar->setRange(0, fileCount);
+	progressBar->setValue(finishedCount);
+}
+
+void BatchDialog::batchFinished(const BatchRunner::Summary& summary)
+{
+	statusLabel->setText(QString("%1 files, %2 failed, %3 s, %4 files/s, %5 MB/s")
+						 .arg(summary.fileCount)
+						 .arg(summary.failedCount)
+						 .arg(summary.elapsed / 1000.0, 0, 'f', 1)
+						 .arg(summary.filesPerSecond(), 0, 'f', 1)
+						 .arg(summary.megabytesPerSecond(), 0, 'f', 2));
+	setRunning(false);
+}
+
+void BatchDialog::batchFailed(const QString& message)
+{
+	statusLabel->setText(message);
+	setRunning(false);
+}
+
+void BatchDialog::setRunning(bool isRunning)
+{
+	buttonStart->setEnabled(!isRunning);
+	buttonCancel->setText(isRunning ? "&Cancel" : "&Close");
+
+	// Engines of finished batch are released on batch thread
+	if (!isRunning && runner != NULL) {
+		runner->deleteLater();
+		runner = NULL;
+	}
+}
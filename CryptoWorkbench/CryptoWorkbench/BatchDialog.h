@@ -0,0 +1,60 @@
+#ifndef BATCHDIALOG_H
+#define BATCHDIALOG_H
+
+#include <QDialog>
+#include "Environment.h"
+#include "BatchRunner.h"
+
+class QLineEdit;
+class QComboBox;
+class QSpinBox;
+class QProgressBar;
+class QLabel;
+class QPushButton;
+class QThread;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Dialog running current script over files matching pattern
+/// Batch runs on its own thread with separate pool of engines
+///
+////////////////////////////////////////////////////////////////////////////////////
+class BatchDialog : public QDialog
+{
+	Q_OBJECT
+
+public:
+	BatchDialog(const Environment& engineEnvironment, const QString& script, QWidget* parent = 0);
+	~BatchDialog();
+
+signals:
+	void runRequested(const QString& scriptText, const QStringList& inputFiles, const QString& outputPath, bool isJsonLines);
+
+private slots:
+	void browseInputClicked();
+	void browseOutputClicked();
+	void startClicked();
+	void cancelClicked();
+	void batchProgress(int finishedCount, int fileCount);
+	void batchFinished(const BatchRunner::Summary& summary);
+	void batchFailed(const QString& message);
+
+private:
+	void setRunning(bool isRunning);
+
+private:
+	Environment environment;
+	QString scriptText;
+	QThread* batchThread;
+	BatchRunner* runner;
+	QLineEdit* inputEdit;
+	QLineEdit* outputEdit;
+	QComboBox* outputModeCombo;
+	QSpinBox* engineCountSpin;
+	QProgressBar* progressBar;
+	QLabel* statusLabel;
+	QPushButton* buttonStart;
+	QPushButton* buttonCancel;
+};
+
+#endif // BATCHDIALOG_H
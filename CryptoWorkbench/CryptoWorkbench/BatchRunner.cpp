@@ -0,0 +1,161 @@
+#include "BatchRunner.h"
+#include "WorkerPool.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <cstdio>
+
+
+class BatchRunner::FileJob : public WorkerPool::Job
+{
+public:
+	FileJob(BatchRunner* batchRunner, const QStringList& files, QFile* jsonLines, const QString& directory)
+		: runner(batchRunner), inputFiles(files), jsonLinesFile(jsonLines), outputDirectory(directory) {}
+
+	virtual bool input(int index, QString* workspaceText, QString* errorMessage)
+	{
+		QFile file(inputFiles.at(index));
+		if (!file.open(QFile::ReadOnly)) {
+			*errorMessage = QString("Could not open file: %1").arg(inputFiles.at(index));
+			return false;
+		}
+
+		QByteArray data = file.readAll();
+		byteCount.fetchAndAddOrdered(data.size());
+		*workspaceText = QString::fromUtf8(data);
+		return true;
+	}
+
+	virtual void finished(int index, const ScriptResult& result, qint64 runtime)
+	{
+		// Files stopped by cancel() are not reported
+		if (runner->isCancelled.load())
+			return;
+
+		if (!result.isValid())
+			failedCount.fetchAndAddOrdered(1);
+
+		if (jsonLinesFile != NULL)
+			writeJsonLine(index, result, runtime);
+		else
+			writeResultFile(index, result);
+
+		emit runner->progress(finishedCount.fetchAndAddOrdered(1) + 1, inputFiles.count());
+	}
+
+	QAtomicInt failedCount;
+	QAtomicInt finishedCount;
+	QAtomicInteger<qint64> byteCount;
+
+private:
+	void writeJsonLine(int index, const ScriptResult& result, qint64 runtime)
+	{
+		QJsonObject line;
+		line.insert("file", inputFiles.at(index));
+		line.insert("valid", result.isValid());
+		line.insert("result", result.toJson());
+		line.insert("time", runtime);
+		if (result.isFromCache())
+			line.insert("cached", true);
+
+		QByteArray data = QJsonDocument(line).toJson(QJsonDocument::Compact);
+		data.append('\n');
+
+		// Lines of different files must not interleave
+		QMutexLocker locker(&mutex);
+		jsonLinesFile->write(data);
+		jsonLinesFile->flush();
+	}
+
+	void writeResultFile(int index, const ScriptResult& result)
+	{
+		QString fileName = QFileInfo(inputFiles.at(index)).fileName() + (result.isValid() ? ".out" : ".err");
+		QFile file(outputDirectory + fileName);
+		if (file.open(QFile::WriteOnly | QFile::Truncate))
+			file.write(result.rawData());
+	}
+
+private:
+	BatchRunner* runner;
+	QStringList inputFiles;
+	QFile* jsonLinesFile;
+	QString outputDirectory;
+	QMutex mutex;
+};
+
+
+BatchRunner::BatchRunner(const Environment& environment, int engineCount, QObject* parent)
+	: QObject(parent), pool(new WorkerPool(environment, engineCount))
+{
+	qRegisterMetaType<BatchRunner::Summary>("BatchRunner::Summary");
+}
+
+BatchRunner::~BatchRunner()
+{
+	delete pool;
+}
+
+QStringList BatchRunner::expandGlob(const QString& pattern)
+{
+	QFileInfo patternInfo(pattern);
+	QDir directory = patternInfo.isDir() ? QDir(pattern) : patternInfo.dir();
+	QStringList nameFilters;
+	if (!patternInfo.isDir())
+		nameFilters.append(patternInfo.fileName());
+
+	QStringList files;
+	QStringList names = directory.entryList(nameFilters, QDir::Files, QDir::Name);
+	for (int i = 0; i < names.count(); i++)
+		files.append(directory.filePath(names.at(i)));
+	return files;
+}
+
+void BatchRunner::cancel()
+{
+	isCancelled.store(1);
+	pool->terminate();
+}
+
+bool BatchRunner::run(const QString& scriptText, const QStringList& inputFiles, const QString& outputPath, bool isJsonLines)
+{
+	lastSummary = Summary();
+	lastErrorMessage.clear();
+	isCancelled.store(0);
+
+	QFile jsonLinesFile(outputPath);
+	QString outputDirectory;
+	if (isJsonLines) {
+		bool isOpen = (outputPath == "-") ? jsonLinesFile.open(stdout, QFile::WriteOnly) : jsonLinesFile.open(QFile::WriteOnly | QFile::Truncate);
+		if (!isOpen) {
+			lastErrorMessage = QString("Could not open output file: %1").arg(outputPath);
+			emit failed(lastErrorMessage);
+			return false;
+		}
+	}
+	else {
+		if (!QDir().mkpath(outputPath)) {
+			lastErrorMessage = QString("Could not create output directory: %1").arg(outputPath);
+			emit failed(lastErrorMessage);
+			return false;
+		}
+		outputDirectory = QDir(outputPath).absolutePath() + "/";
+	}
+
+	FileJob job(this, inputFiles, isJsonLines ? &jsonLinesFile : NULL, outputDirectory);
+
+	QElapsedTimer timer;
+	timer.start();
+	pool->evaluateEach(scriptText, inputFiles.count(), &job);
+
+	lastSummary.fileCount = job.finishedCount.load();
+	lastSummary.failedCount = job.failedCount.load();
+	lastSummary.byteCount = job.byteCount.load();
+	lastSummary.elapsed = timer.elapsed();
+	emit finished(lastSummary);
+	return true;
+}
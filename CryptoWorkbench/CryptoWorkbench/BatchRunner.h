@@ -0,0 +1,73 @@
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QMetaType>
+#include <QAtomicInt>
+#include "Environment.h"
+
+class WorkerPool;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Runs one script over many input files on a pool of engines
+/// Each file is passed as workspace, results are written as soon as they are ready
+///
+////////////////////////////////////////////////////////////////////////////////////
+class BatchRunner : public QObject
+{
+	Q_OBJECT
+
+	class FileJob;
+
+public:
+	struct Summary
+	{
+		Summary() : fileCount(0), failedCount(0), byteCount(0), elapsed(0) {}
+
+		double filesPerSecond() const { return elapsed > 0 ? fileCount * 1000.0 / elapsed : 0.0; }
+		double megabytesPerSecond() const { return elapsed > 0 ? byteCount * 1000.0 / elapsed / (1024.0 * 1024.0) : 0.0; }
+
+		int fileCount;
+		int failedCount;
+		qint64 byteCount;
+		qint64 elapsed;
+	};
+
+	BatchRunner(const Environment& environment, int engineCount, QObject* parent = NULL);
+	~BatchRunner();
+
+	// Files matching wildcard in last path component, all files when pattern is a directory
+	static QStringList expandGlob(const QString& pattern);
+
+	// Stop running batch, remaining files are skipped, can be called from any thread
+	void cancel();
+
+	const Summary& summary() const { return lastSummary; }
+
+	// Reason of last run() failure
+	const QString& errorMessage() const { return lastErrorMessage; }
+
+public slots:
+	// Results go to one JSON object per line in outputPath when isJsonLines is set, "-" for standard output
+	// Otherwise every input gets <name>.out or <name>.err file in outputPath directory
+	// Returns false when output can't be opened, failures of scripts are counted in summary
+	bool run(const QString& scriptText, const QStringList& inputFiles, const QString& outputPath, bool isJsonLines);
+
+signals:
+	void progress(int finishedCount, int fileCount);
+	void finished(const BatchRunner::Summary& summary);
+	void failed(const QString& message);
+
+private:
+	WorkerPool* pool;
+	Summary lastSummary;
+	QString lastErrorMessage;
+	QAtomicInt isCancelled;
+};
+
+Q_DECLARE_METATYPE(BatchRunner::Summary)
+
+#endif // BATCHRUNNER_H
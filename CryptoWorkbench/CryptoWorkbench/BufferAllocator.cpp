@@ -0,0 +1,151 @@
+#include "BufferAllocator.h"
+#include <cstdlib>
+#include <cstring>
+#include <QtGlobal>
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Memory kept in free lists, buffers freed above it are returned to the system
+static const size_t MaxPooledBytes = 16 * 1024 * 1024;
+
+
+BufferAllocator::BufferAllocator()
+{
+	for (int i = 0; i < SizeClassCount; i++)
+		freeLists[i] = NULL;
+}
+
+BufferAllocator::~BufferAllocator()
+{
+	for (int i = 0; i < SizeClassCount; i++) {
+		while (freeLists[i] != NULL) {
+			FreeBlock* block = freeLists[i];
+			freeLists[i] = block->next;
+			free(block);
+		}
+	}
+}
+
+void* BufferAllocator::Allocate(size_t length)
+{
+	return allocate(length, true);
+}
+
+void* BufferAllocator::AllocateUninitialized(size_t length)
+{
+	return allocate(length, false);
+}
+
+void BufferAllocator::Free(void* data, size_t length)
+{
+	if (data == NULL)
+		return;
+
+	int index = sizeClass(length);
+
+	QMutexLocker locker(&mutex);
+	stats.liveBytes -= length;
+
+	if (index < 0) {
+		locker.unlock();
+		unmapMemory(data, length);
+		return;
+	}
+
+	size_t classSize = size_t(1) << (index + MinClassShift);
+	if (stats.pooledBytes + classSize > MaxPooledBytes) {
+		locker.unlock();
+		free(data);
+		return;
+	}
+
+	FreeBlock* block = static_cast<FreeBlock*>(data);
+	block->next = freeLists[index];
+	freeLists[index] = block;
+	stats.pooledBytes += classSize;
+}
+
+BufferAllocator::Statistics BufferAllocator::statistics() const
+{
+	QMutexLocker locker(&mutex);
+	return stats;
+}
+
+void BufferAllocator::resetPeak()
+{
+	QMutexLocker locker(&mutex);
+	stats.peakBytes = stats.liveBytes;
+}
+
+void* BufferAllocator::allocate(size_t length, bool isZeroed)
+{
+	int index = sizeClass(length);
+	void* data = NULL;
+
+	{
+		QMutexLocker locker(&mutex);
+		stats.allocationCount++;
+		stats.liveBytes += length;
+		stats.peakBytes = qMax(stats.peakBytes, stats.liveBytes);
+
+		if (index >= 0) {
+			stats.pooledAllocationCount++;
+			if (freeLists[index] != NULL) {
+				data = freeLists[index];
+				freeLists[index] = freeLists[index]->next;
+				stats.poolHitCount++;
+				stats.pooledBytes -= size_t(1) << (index + MinClassShift);
+			}
+		}
+	}
+
+	// Mapped pages are zeroed by the system
+	if (index < 0)
+		data = mapMemory(length);
+	else if (data == NULL)
+		data = malloc(size_t(1) << (index + MinClassShift));
+
+	if (data == NULL) {
+		QMutexLocker locker(&mutex);
+		stats.liveBytes -= length;
+		return NULL;
+	}
+
+	if (isZeroed && index >= 0)
+		memset(data, 0, length);
+	return data;
+}
+
+int BufferAllocator::sizeClass(size_t length)
+{
+	if (length > (size_t(1) << MaxClassShift))
+		return -1;
+
+	int shift = MinClassShift;
+	while ((size_t(1) << shift) < length)
+		shift++;
+	return shift - MinClassShift;
+}
+
+void* BufferAllocator::mapMemory(size_t length)
+{
+#ifdef Q_OS_WIN
+	return VirtualAlloc(NULL, length, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+	void* data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return data == MAP_FAILED ? NULL : data;
+#endif
+}
+
+void BufferAllocator::unmapMemory(void* data, size_t length)
+{
+#ifdef Q_OS_WIN
+	Q_UNUSED(length);
+	VirtualFree(data, 0, MEM_RELEASE);
+#else
+	munmap(data, length);
+#endif
+}
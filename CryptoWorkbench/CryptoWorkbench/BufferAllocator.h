@@ -0,0 +1,69 @@
+#ifndef BUFFERALLOCATOR_H
+#define BUFFERALLOCATOR_H
+
+#include <QMutex>
+#include "include/v8.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// ArrayBuffer allocator keeping freed small buffers in per size class free lists.
+/// Large buffers are mapped directly from the system and come already zeroed.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class BufferAllocator : public v8::ArrayBuffer::Allocator
+{
+public:
+	struct Statistics
+	{
+		Statistics() : liveBytes(0), peakBytes(0), pooledBytes(0), allocationCount(0), pooledAllocationCount(0), poolHitCount(0) {}
+
+		// Share of size class allocations served from free lists
+		double hitRate() const { return pooledAllocationCount > 0 ? double(poolHitCount) / pooledAllocationCount : 0.0; }
+
+		size_t liveBytes;
+		size_t peakBytes;
+		size_t pooledBytes;
+		quint64 allocationCount;
+		quint64 pooledAllocationCount;
+		quint64 poolHitCount;
+	};
+
+	BufferAllocator();
+	virtual ~BufferAllocator();
+
+	virtual void* Allocate(size_t length);
+	virtual void* AllocateUninitialized(size_t length);
+	virtual void Free(void* data, size_t length);
+
+	Statistics statistics() const;
+
+	// Start measuring peak from current live bytes
+	void resetPeak();
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	enum
+	{
+		MinClassShift = 6,     // 64 B
+		MaxClassShift = 16,    // 64 KB
+		SizeClassCount = MaxClassShift - MinClassShift + 1,
+	};
+
+	void* allocate(size_t length, bool isZeroed);
+	static int sizeClass(size_t length);
+	static void* mapMemory(size_t length);
+	static void unmapMemory(void* data, size_t length);
+
+private:
+	FreeBlock* freeLists[SizeClassCount];
+	mutable QMutex mutex;
+	Statistics stats;
+
+	Q_DISABLE_COPY(BufferAllocator)
+};
+
+#endif // BUFFERALLOCATOR_H
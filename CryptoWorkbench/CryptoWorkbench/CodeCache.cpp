@@ -0,0 +1,50 @@
+#include "CodeCache.h"
+#include <QFile>
+#include <QCryptographicHash>
+
+using namespace v8;
+
+
+CodeCache::CodeCache(const QString& scriptFilePath, const QByteArray& scriptSource)
+	: cacheFilePath(scriptFilePath + ".cache")
+{
+	// Header of cache file, data is valid only for the same V8 build and the same source
+	cacheKey.append(V8::GetVersion());
+	cacheKey.append('\n');
+	cacheKey.append(QCryptographicHash::hash(scriptSource, QCryptographicHash::Sha1).toHex());
+	cacheKey.append('\n');
+}
+
+ScriptCompiler::CachedData* CodeCache::load() const
+{
+	QFile file(cacheFilePath);
+	if (!file.open(QFile::ReadOnly))
+		return NULL;
+
+	QByteArray content = file.readAll();
+	if (!content.startsWith(cacheKey) || content.size() == cacheKey.size())
+		return NULL;
+
+	int length = content.size() - cacheKey.size();
+	uint8_t* buffer = new uint8_t[length];
+	memcpy(buffer, content.constData() + cacheKey.size(), length);
+	return new ScriptCompiler::CachedData(buffer, length, ScriptCompiler::CachedData::BufferOwned);
+}
+
+void CodeCache::store(const ScriptCompiler::CachedData* data) const
+{
+	if (data == NULL || data->length == 0)
+		return;
+
+	QFile file(cacheFilePath);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+		return;
+
+	file.write(cacheKey);
+	file.write(reinterpret_cast<const char*>(data->data), data->length);
+}
+
+void CodeCache::remove() const
+{
+	QFile::remove(cacheFilePath);
+}
@@ -0,0 +1,34 @@
+#ifndef CODECACHE_H
+#define CODECACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include "include/v8.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Compiled code cache for one script file, stored next to the script.
+/// Cache is keyed by V8 version and hash of script source.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class CodeCache
+{
+public:
+	CodeCache(const QString& scriptFilePath, const QByteArray& scriptSource);
+
+	// Returns cached data for the script or NULL when cache is missing or stale
+	// Ownership of returned data is passed to the caller
+	v8::ScriptCompiler::CachedData* load() const;
+
+	// Write data produced by compiler to cache file
+	void store(const v8::ScriptCompiler::CachedData* data) const;
+
+	// Delete cache file, used when V8 rejects cached data
+	void remove() const;
+
+private:
+	QString cacheFilePath;
+	QByteArray cacheKey;
+};
+
+#endif // CODECACHE_H
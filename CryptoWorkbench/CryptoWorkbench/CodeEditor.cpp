@@ -1,11 +1,12 @@
 #include "CodeEditor.h"
+#include "ScriptCell.h"
 #include <QPainter>
 #include <QTextBlock>
 #include <QTextDocumentFragment>
 #include <QDebug>
 
 CodeEditor::CodeEditor(QWidget *parent)
-	: QPlainTextEdit(parent)
+	: cellTimeWidth(0), isCellModeEnabled(false), QPlainTextEdit(parent)
 {
 	connect(this, SIGNAL(blockCountChanged(int)), this, SLOT(updateLineNumberAreaWidth(int)));
 	connect(this, SIGNAL(updateRequest(QRect, int)), this, SLOT(updateLineNumberArea(QRect, int)));
@@ -78,6 +79,20 @@ void CodeEditor::uncommentSelection()
 	setTextCursor(cursor);
 }
 
+void CodeEditor::setCellMode(bool isEnabled)
+{
+	isCellModeEnabled = isEnabled;
+	cellTimes.clear();
+	updateLineNumberAreaWidth(0);
+	lineNumberArea->update();
+}
+
+void CodeEditor::setCellTimes(const QVector<qint64>& times)
+{
+	cellTimes = times;
+	lineNumberArea->update();
+}
+
 void CodeEditor::updateLineNumberAreaWidth(int newBlockCount)
 {
 	Q_UNUSED(newBlockCount);
@@ -89,7 +104,11 @@ void CodeEditor::updateLineNumberAreaWidth(int newBlockCount)
 		++digits;
 	}
 
-	lineNumberAreaWidth = 12 + fontMetrics().width(QLatin1Char('9')) * digits;
+	// Cell runtime is drawn left of line numbers
+	cellTimeWidth = isCellModeEnabled ? 8 + fontMetrics().width("99999 ms") : 0;
+	lineNumberAreaWidth = cellTimeWidth + 12 + fontMetrics().width(QLatin1Char('9')) * digits;
+	QRect cr = contentsRect();
+	lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth, cr.height()));
 	setViewportMargins(lineNumberAreaWidth + 2, 0, 0, 0);
 }
 
@@ -131,10 +150,33 @@ void CodeEditor::lineNumberAreaPaintEvent(QPaintEvent* event)
 	int top = (int)blockBoundingGeometry(block).translated(contentOffset()).top();
 	int bottom = top + (int)blockBoundingRect(block).height();
 
+	// Cells above visible area, first line always opens a cell
+	int cellIndex = -1;
+	if (isCellModeEnabled) {
+		cellIndex = 0;
+		for (QTextBlock previous = document()->begin().next(); previous.isValid() && previous.blockNumber() < block.blockNumber(); previous = previous.next()) {
+			if (ScriptCell::isMarker(previous.text()))
+				cellIndex++;
+		}
+	}
+
 	while (block.isValid() && top <= event->rect().bottom()) {
+		bool isCellStart = isCellModeEnabled && blockNumber > 1 && ScriptCell::isMarker(block.text());
+		if (isCellStart)
+			cellIndex++;
+
 		if (block.isVisible() && bottom >= event->rect().top()) {
 			QString number = QString::number(blockNumber);
 			painter.drawText(0, top, lineNumberAreaWidth - 5, fontMetrics().height(), Qt::AlignRight | Qt::AlignVCenter, number);
+
+			if (isCellStart)
+				painter.drawLine(0, top, lineNumberAreaWidth, top);
+
+			if ((isCellStart || (isCellModeEnabled && blockNumber == 1)) && cellIndex < cellTimes.count()) {
+				qint64 time = cellTimes.at(cellIndex);
+				QString timeText = (time < 0) ? QString("cached") : QString("%1 ms").arg(time);
+				painter.drawText(4, top, cellTimeWidth, fontMetrics().height(), Qt::AlignLeft | Qt::AlignVCenter, timeText);
+			}
 		}
 
 		block = block.next();
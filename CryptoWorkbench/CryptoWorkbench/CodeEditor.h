@@ -3,6 +3,7 @@
 
 #include <QPlainTextEdit>
 #include <QTextBlock>
+#include <QVector>
 
 class LineNumberArea;
 
@@ -28,6 +29,13 @@ public:
 	void commentSelection();
 	void uncommentSelection();
 
+	// Cell mode marks cells in the gutter together with their last runtime
+	void setCellMode(bool isEnabled);
+	bool isCellMode() const { return isCellModeEnabled; }
+
+	// Runtime in ms for each cell, -1 marks cell reused from previous run
+	void setCellTimes(const QVector<qint64>& times);
+
 protected:
 	void resizeEvent(QResizeEvent* event);
 	void lineNumberAreaPaintEvent(QPaintEvent* event);
@@ -44,7 +52,10 @@ private:
 
 private:
 	int lineNumberAreaWidth;
+	int cellTimeWidth;
 	int editorTabSize;
+	bool isCellModeEnabled;
+	QVector<qint64> cellTimes;
 	LineNumberArea* lineNumberArea;
 	QColor lineNumbersBackgroundColor;
 	QColor lineNumbersForegroundColor;
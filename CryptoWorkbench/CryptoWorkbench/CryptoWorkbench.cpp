@@ -1,37 +1,73 @@
 #include "CryptoWorkbench.h"
 #include "JavascriptInterface.h"
 #include "ScriptHighlighter.h"
+#include "ProfileView.h"
+#include "HeapView.h"
+#include "BatchDialog.h"
+#include "JobQueue.h"
+#include "JobView.h"
+#include "NativeView.h"
 #include "Environment.h"
 #include <QSplitter>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QLabel>
 #include <QPushButton>
+#include <QTabWidget>
+#include <QComboBox>
 #include <QShortcut>
 #include <QFileDialog>
 #include <QElapsedTimer>
 #include <QDebug>
 
+// Jobs running at once in background, each job has its own engine
+static const int JobEngineCount = 2;
+
 CryptoWorkbench::CryptoWorkbench(QWidget *parent)
-	: isCodeChanged(false), helpWidget(NULL), QMainWindow(parent)
+	: isCodeChanged(false), isResultCacheBypassed(false), helpWidget(NULL), QMainWindow(parent)
 {
 	ui.setupUi(this);
+	jobQueue = new JobQueue(defaultEnvironment(), JobEngineCount, this);
 	createUi();
 	loadDefaultFiles();
 
+	js = new JavascriptInterface(defaultEnvironment(), this);
+	connect(js, &JavascriptInterface::evaluationFinished, this, &CryptoWorkbench::evaluationFinished);
+	connect(js, &JavascriptInterface::outputWritten, this, &CryptoWorkbench::outputWritten);
+	connect(js, &JavascriptInterface::cellsFinished, this, &CryptoWorkbench::cellsFinished);
+	connect(js, &JavascriptInterface::profileFinished, this, &CryptoWorkbench::profileFinished);
+	connect(js, &JavascriptInterface::heapUsageMeasured, this, &CryptoWorkbench::heapUsageMeasured);
+	connect(js, &JavascriptInterface::heapSnapshotFinished, this, &CryptoWorkbench::heapSnapshotFinished);
+	connect(js, &JavascriptInterface::nativeStatisticsMeasured, nativeView, &NativeView::setCounters);
+	connect(nativeView, &NativeView::collectionToggled, js, &JavascriptInterface::setNativeStatisticsEnabled);
+}
+
+CryptoWorkbench::~CryptoWorkbench()
+{
+	saveActiveScript();
+}
+
+Environment CryptoWorkbench::defaultEnvironment()
+{
 	Environment e;
 	e.coreLibraryName = "corelib.js";
 	e.coreLibraryPath = "../data/";
 	e.currentScriptName = "current.js";
 	e.workspaceName = "workspace";
 	e.scriptLoadPath = "../scripts/";
-
-	js = new JavascriptInterface(e, this);
-}
-
-CryptoWorkbench::~CryptoWorkbench()
-{
-	saveActiveScript();
+	e.persistentContext = true;
+	e.codeCache = true;
+	e.maxHeapSize = sizeof(void*) == 4 ? 512 : 1024;
+	e.resultCacheDirectory = "../cache/results/";
+
+#ifdef QT_NO_DEBUG
+	e.v8DataPath = "../bin/";
+	e.startupSnapshotPath = "../bin/workbench_snapshot.bin";
+#else
+	e.v8DataPath = "../bin_debug/";
+	e.startupSnapshotPath = "../bin_debug/workbench_snapshot.bin";
+#endif
+	return e;
 }
 
 void CryptoWorkbench::createUi()
@@ -44,7 +80,25 @@ void CryptoWorkbench::createUi()
 	splitterV->addWidget(createCodeEditor(splitterV));
 	splitterV->setSizes(QList<int>() << 400 << 300);
 
-	mainHorizontalLayout->addWidget(splitterV);
+	// Side panel is shown after first profiled run or on demand
+	QSplitter* splitterH = new QSplitter(Qt::Horizontal, ui.centralWidget);
+	sidePanel = new QTabWidget(splitterH);
+	profileView = new ProfileView(sidePanel);
+	heapView = new HeapView(sidePanel);
+	connect(heapView, &HeapView::snapshotRequested, this, &CryptoWorkbench::heapSnapshotRequested);
+	sidePanel->addTab(profileView, "Profile");
+	sidePanel->addTab(heapView, "Heap");
+	nativeView = new NativeView(sidePanel);
+	sidePanel->addTab(nativeView, "Natives");
+	jobView = new JobView(jobQueue, sidePanel);
+	connect(jobView, &JobView::openRequested, this, &CryptoWorkbench::jobOpenRequested);
+	sidePanel->addTab(jobView, "Jobs");
+	sidePanel->hide();
+	splitterH->addWidget(splitterV);
+	splitterH->addWidget(sidePanel);
+	splitterH->setSizes(QList<int>() << 700 << 500);
+
+	mainHorizontalLayout->addWidget(splitterH);
 
 	QFont font;
 	font.setFamily("Lucida Console");
@@ -71,6 +125,18 @@ void CryptoWorkbench::createUi()
 	QShortcut* runShortcut2 = new QShortcut(QKeySequence("F5"), this);
 	connect(runShortcut2, &QShortcut::activated, this, &CryptoWorkbench::runClicked);
 
+	QShortcut* profileShortcut = new QShortcut(QKeySequence("Ctrl+F5"), this);
+	connect(profileShortcut, &QShortcut::activated, this, &CryptoWorkbench::profileClicked);
+
+	QShortcut* stopShortcut = new QShortcut(QKeySequence("Shift+F5"), this);
+	connect(stopShortcut, &QShortcut::activated, this, &CryptoWorkbench::stopClicked);
+
+	QShortcut* resetShortcut = new QShortcut(QKeySequence("Ctrl+Shift+R"), this);
+	connect(resetShortcut, &QShortcut::activated, this, &CryptoWorkbench::resetClicked);
+
+	QShortcut* batchShortcut = new QShortcut(QKeySequence("Ctrl+B"), this);
+	connect(batchShortcut, &QShortcut::activated, this, &CryptoWorkbench::batchClicked);
+
 	QShortcut* helpShortcut = new QShortcut(QKeySequence("F1"), this);
 	connect(helpShortcut, &QShortcut::activated, this, &CryptoWorkbench::helpClicked);
 
@@ -111,7 +177,63 @@ QWidget* CryptoWorkbench::createCodeEditor(QWidget* parent)
 	connect(buttonHelp, &QPushButton::clicked, this, &CryptoWorkbench::helpClicked);
 	toolbarLayout->addWidget(buttonHelp);
 
-	QPushButton* buttonRunScript = new QPushButton("&Run", widget);
+	QPushButton* buttonResetEngine = new QPushButton("Rese&t", widget);
+	buttonResetEngine->setMinimumHeight(30);
+	connect(buttonResetEngine, &QPushButton::clicked, this, &CryptoWorkbench::resetClicked);
+	toolbarLayout->addWidget(buttonResetEngine);
+
+	// Rendering of typed results, text results are shown as they are
+	resultFormatBox = new QComboBox(widget);
+	resultFormatBox->setMinimumHeight(30);
+	resultFormatBox->addItem("Text", ScriptResult::FormatText);
+	resultFormatBox->addItem("Hex", ScriptResult::FormatHex);
+	resultFormatBox->addItem("CSV", ScriptResult::FormatCsv);
+	resultFormatBox->addItem("JSON", ScriptResult::FormatJson);
+	connect(resultFormatBox, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &CryptoWorkbench::resultFormatChanged);
+	toolbarLayout->addWidget(resultFormatBox);
+
+	// Script split by //%% lines, unchanged leading cells are not run again
+	buttonCellMode = new QPushButton("&Cells", widget);
+	buttonCellMode->setMinimumHeight(30);
+	buttonCellMode->setCheckable(true);
+	connect(buttonCellMode, &QPushButton::toggled, this, &CryptoWorkbench::cellModeToggled);
+	toolbarLayout->addWidget(buttonCellMode);
+
+	// Unchecked runs every script again, fresh results still replace cached ones
+	QPushButton* buttonResultCache = new QPushButton("C&ached", widget);
+	buttonResultCache->setMinimumHeight(30);
+	buttonResultCache->setCheckable(true);
+	buttonResultCache->setChecked(true);
+	connect(buttonResultCache, &QPushButton::toggled, this, &CryptoWorkbench::resultCacheToggled);
+	toolbarLayout->addWidget(buttonResultCache);
+
+	buttonStopScript = new QPushButton("Stop", widget);
+	buttonStopScript->setMinimumHeight(30);
+	buttonStopScript->setEnabled(false);
+	connect(buttonStopScript, &QPushButton::clicked, this, &CryptoWorkbench::stopClicked);
+	toolbarLayout->addWidget(buttonStopScript);
+
+	QPushButton* buttonBatch = new QPushButton("&Batch...", widget);
+	buttonBatch->setMinimumHeight(30);
+	connect(buttonBatch, &QPushButton::clicked, this, &CryptoWorkbench::batchClicked);
+	toolbarLayout->addWidget(buttonBatch);
+
+	QPushButton* buttonHeap = new QPushButton("H&eap", widget);
+	buttonHeap->setMinimumHeight(30);
+	connect(buttonHeap, &QPushButton::clicked, this, &CryptoWorkbench::heapClicked);
+	toolbarLayout->addWidget(buttonHeap);
+
+	QPushButton* buttonQueueScript = new QPushButton("&Queue", widget);
+	buttonQueueScript->setMinimumHeight(30);
+	connect(buttonQueueScript, &QPushButton::clicked, this, &CryptoWorkbench::queueClicked);
+	toolbarLayout->addWidget(buttonQueueScript);
+
+	buttonProfileScript = new QPushButton("&Profile", widget);
+	buttonProfileScript->setMinimumHeight(30);
+	connect(buttonProfileScript, &QPushButton::clicked, this, &CryptoWorkbench::profileClicked);
+	toolbarLayout->addWidget(buttonProfileScript);
+
+	buttonRunScript = new QPushButton("&Run", widget);
 	buttonRunScript->setMinimumHeight(30);
 	connect(buttonRunScript, &QPushButton::clicked, this, &CryptoWorkbench::runClicked);
 	toolbarLayout->addWidget(buttonRunScript);
@@ -199,6 +321,19 @@ void CryptoWorkbench::saveAsClicked()
 
 void CryptoWorkbench::runClicked()
 {
+	runScript(false);
+}
+
+void CryptoWorkbench::profileClicked()
+{
+	runScript(true);
+}
+
+void CryptoWorkbench::runScript(bool isProfiled)
+{
+	if (js->isRunning())
+		return;
+
 	if (isCodeChanged)
 		saveActiveScript();
 
@@ -206,18 +341,184 @@ void CryptoWorkbench::runClicked()
 	QString workspaceText = workspaceEditor->toPlainText();
 
 	workspaceEditor->setPlainText("");
+	workspaceEditor->setReadOnly(true);
+	buttonRunScript->setEnabled(false);
+	buttonProfileScript->setEnabled(false);
+	buttonStopScript->setEnabled(true);
+
+	ui.statusBar->showMessage(isProfiled ? "Profiling..." : "Running...");
+	ui.statusBar->setStyleSheet("QStatusBar { background-color: #ca5100; }");
+
+	if (codeEditor->isCellMode() && !isProfiled)
+		js->evaluateCells(script, workspaceText);
+	else
+		js->evaluate(script, workspaceText, isProfiled);
+}
 
-	QElapsedTimer timer;
-	timer.start();
-	ScriptResult result = js->evaluate(script, workspaceText);
+void CryptoWorkbench::stopClicked()
+{
+	js->stop();
+}
+
+void CryptoWorkbench::evaluationFinished(const ScriptResult& result, qint64 runtime)
+{
+	workspaceEditor->setReadOnly(false);
+	buttonRunScript->setEnabled(true);
+	buttonProfileScript->setEnabled(true);
+	buttonStopScript->setEnabled(false);
+
+	BufferAllocator::Statistics bufferStats = js->allocatorStatistics();
+	double heapDelta = (double(lastHeapAfter.usedHeapSize) - double(lastHeapBefore.usedHeapSize)) / (1024.0 * 1024.0);
+	ui.statusBar->showMessage(QString("Script runtime: %1 ms    Heap: %2 MB (%3 MB)    Buffers: %4 KB live, %5 KB peak, %6 allocations, %7% pool hits")
+							  .arg(runtime)
+							  .arg(lastHeapAfter.usedHeapSize / (1024.0 * 1024.0), 0, 'f', 1)
+							  .arg(heapDelta, 0, 'f', 1)
+							  .arg(bufferStats.liveBytes / 1024)
+							  .arg(bufferStats.peakBytes / 1024)
+							  .arg(bufferStats.allocationCount)
+							  .arg(bufferStats.hitRate() * 100.0, 0, 'f', 1));
+	if (result.isFromCache())
+		ui.statusBar->showMessage(QString("Cached result (%1 ms)    Uncheck Cached to run script again").arg(runtime));
 
-	ui.statusBar->showMessage(QString("Script runtime: %1 ms").arg(timer.elapsed()));
 	if (result.isValid())
 		ui.statusBar->setStyleSheet("QStatusBar { background-color: #326c00; }");
 	else
 		ui.statusBar->setStyleSheet("QStatusBar { background-color: #6c0e00; }");
 
-	workspaceEditor->appendPlainText(result.data());
+	ScriptResult::Format format = static_cast<ScriptResult::Format>(resultFormatBox->currentData().toInt());
+	lastResult = result;
+	lastRenderedResult = (result.type() == ScriptResult::TypeText) ? result.data() : result.render(format);
+
+	// Streamed output is already shown, empty result adds nothing
+	if (!lastRenderedResult.isEmpty())
+		workspaceEditor->appendPlainText(lastRenderedResult);
+}
+
+void CryptoWorkbench::cellModeToggled(bool isChecked)
+{
+	codeEditor->setCellMode(isChecked);
+}
+
+void CryptoWorkbench::resultCacheToggled(bool isChecked)
+{
+	// Jobs and batches run scripts of the same editor, they follow the same setting
+	isResultCacheBypassed = !isChecked;
+	js->setResultCacheBypassed(isResultCacheBypassed);
+	jobQueue->setResultCacheBypassed(isResultCacheBypassed);
+}
+
+void CryptoWorkbench::cellsFinished(const QVector<qint64>& cellTimes)
+{
+	codeEditor->setCellTimes(cellTimes);
+}
+
+void CryptoWorkbench::resultFormatChanged(int index)
+{
+	// Render last typed result again unless workspace was edited since
+	if (lastResult.type() == ScriptResult::TypeText || js->isRunning() || workspaceEditor->toPlainText() != lastRenderedResult)
+		return;
+
+	lastRenderedResult = lastResult.render(static_cast<ScriptResult::Format>(resultFormatBox->itemData(index).toInt()));
+	workspaceEditor->setPlainText(lastRenderedResult);
+}
+
+void CryptoWorkbench::outputWritten(const QString& chunk)
+{
+	// Chunks are not lines, append without paragraph break
+	workspaceEditor->moveCursor(QTextCursor::End);
+	workspaceEditor->insertPlainText(chunk);
+}
+
+void CryptoWorkbench::profileFinished(const ScriptProfile& profile)
+{
+	profileView->setProfile(profile);
+	sidePanel->setCurrentWidget(profileView);
+	sidePanel->show();
+}
+
+void CryptoWorkbench::heapUsageMeasured(const HeapUsage& before, const HeapUsage& after)
+{
+	lastHeapBefore = before;
+	lastHeapAfter = after;
+	heapView->setHeapUsage(before, after);
+}
+
+void CryptoWorkbench::queueClicked()
+{
+	if (isCodeChanged)
+		saveActiveScript();
+
+	// Job runs on its own engine, workspace stays editable
+	QString name = currentFileName.isEmpty() ? QString("script") : currentFileName;
+	jobQueue->enqueue(name, codeEditor->toPlainText(), workspaceEditor->toPlainText(), jobView->priority());
+
+	sidePanel->setCurrentWidget(jobView);
+	sidePanel->show();
+}
+
+void CryptoWorkbench::jobOpenRequested(int id)
+{
+	const JobQueue::Job* job = jobQueue->job(id);
+	if (js->isRunning() || job == NULL || job->status == JobQueue::Job::StatusQueued || job->status == JobQueue::Job::StatusRunning)
+		return;
+
+	// Result is shown the same way as result of interactive run
+	ScriptResult::Format format = static_cast<ScriptResult::Format>(resultFormatBox->currentData().toInt());
+	lastResult = job->result;
+	lastRenderedResult = (job->result.type() == ScriptResult::TypeText) ? job->result.data() : job->result.render(format);
+
+	workspaceEditor->setPlainText(job->output);
+	if (!lastRenderedResult.isEmpty())
+		workspaceEditor->appendPlainText(lastRenderedResult);
+
+	ui.statusBar->showMessage(QString("Job %1: %2 ms").arg(job->name).arg(job->runtime));
+	ui.statusBar->setStyleSheet(job->result.isValid() ? "QStatusBar { background-color: #326c00; }" : "QStatusBar { background-color: #6c0e00; }");
+}
+
+void CryptoWorkbench::heapClicked()
+{
+	if (sidePanel->isVisible() && sidePanel->currentWidget() == heapView) {
+		sidePanel->hide();
+	} else {
+		sidePanel->setCurrentWidget(heapView);
+		sidePanel->show();
+	}
+}
+
+void CryptoWorkbench::batchClicked()
+{
+	if (isCodeChanged)
+		saveActiveScript();
+
+	Environment environment = defaultEnvironment();
+	environment.resultCacheBypassed = isResultCacheBypassed;
+	BatchDialog dialog(environment, codeEditor->toPlainText(), this);
+	dialog.exec();
+}
+
+void CryptoWorkbench::heapSnapshotRequested(const QString& filePath)
+{
+	js->writeHeapSnapshot(filePath);
+}
+
+void CryptoWorkbench::heapSnapshotFinished(const QString& filePath, bool isWritten)
+{
+	if (isWritten)
+		ui.statusBar->showMessage(QString("Heap snapshot written: %1").arg(filePath));
+	else
+		ui.statusBar->showMessage(QString("Could not write heap snapshot: %1").arg(filePath));
+}
+
+void CryptoWorkbench::resetClicked()
+{
+	if (js->isRunning())
+		return;
+
+	js->resetEngine();
+	codeEditor->setCellTimes(QVector<qint64>());
+
+	ui.statusBar->showMessage("Engine reset");
+	ui.statusBar->setStyleSheet("QStatusBar { background-color: #007acc; }");
 }
 
 void CryptoWorkbench::helpClicked()
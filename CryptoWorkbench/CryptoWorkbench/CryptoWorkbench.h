@@ -4,9 +4,21 @@
 #include <QtWidgets/QMainWindow>
 #include "ui_CryptoWorkbench.h"
 #include "CodeEditor.h"
+#include "Environment.h"
+#include "ScriptResult.h"
+#include "ScriptProfile.h"
+#include "HeapUsage.h"
 
 class JavascriptInterface;
 class QLabel;
+class QPushButton;
+class QTabWidget;
+class QComboBox;
+class ProfileView;
+class HeapView;
+class JobQueue;
+class JobView;
+class NativeView;
 
 
 class CryptoWorkbench : public QMainWindow
@@ -17,6 +29,9 @@ public:
 	CryptoWorkbench(QWidget *parent = 0);
 	~CryptoWorkbench();
 
+	// Paths and settings used for workbench engine
+	static Environment defaultEnvironment();
+
 private:
 	void createUi();
 	QWidget* createWorkspaceEditor(QWidget* parent);
@@ -24,6 +39,7 @@ private:
 	QWidget* createHelpViewer(QWidget* parent);
 	void loadDefaultFiles();
 	void saveActiveScript();
+	void runScript(bool isProfiled);
 
 private slots:
 	void shortcutActivatedComment();
@@ -31,6 +47,23 @@ private slots:
 	void openClicked();
 	void saveAsClicked();
 	void runClicked();
+	void profileClicked();
+	void stopClicked();
+	void resetClicked();
+	void evaluationFinished(const ScriptResult& result, qint64 runtime);
+	void outputWritten(const QString& chunk);
+	void resultFormatChanged(int index);
+	void cellModeToggled(bool isChecked);
+	void resultCacheToggled(bool isChecked);
+	void cellsFinished(const QVector<qint64>& cellTimes);
+	void profileFinished(const ScriptProfile& profile);
+	void heapUsageMeasured(const HeapUsage& before, const HeapUsage& after);
+	void heapClicked();
+	void queueClicked();
+	void jobOpenRequested(int id);
+	void batchClicked();
+	void heapSnapshotRequested(const QString& filePath);
+	void heapSnapshotFinished(const QString& filePath, bool isWritten);
 	void helpClicked();
 	void codeChanged();
 
@@ -41,7 +74,23 @@ private:
 	CodeEditor* codeEditor;
 	QString currentFileName;
 	bool isCodeChanged;
+	bool isResultCacheBypassed;
 	QWidget* helpWidget;
+	QPushButton* buttonRunScript;
+	QPushButton* buttonStopScript;
+	QPushButton* buttonProfileScript;
+	QComboBox* resultFormatBox;
+	QPushButton* buttonCellMode;
+	QTabWidget* sidePanel;
+	ProfileView* profileView;
+	HeapView* heapView;
+	JobQueue* jobQueue;
+	JobView* jobView;
+	NativeView* nativeView;
+	HeapUsage lastHeapBefore;
+	HeapUsage lastHeapAfter;
+	ScriptResult lastResult;
+	QString lastRenderedResult;
 };
 
 #endif // CRYPTOWORKBENCH_H
@@ -10,6 +10,8 @@
 ////////////////////////////////////////////////////////////////////////////////////
 struct Environment
 {
+	Environment() : persistentContext(false), codeCache(false), maxHeapSize(0), maxRunTime(0), workerCount(0), asyncThreadCount(0), maxCacheSize(256), nativeStatistics(false), maxResultCacheSize(512), resultCacheBypassed(false), bindingProbes(false) {}
+
 	QString coreLibraryName;
 	QString coreLibraryPath;
 
@@ -18,6 +20,51 @@ struct Environment
 	QString workspaceName;
 
 	QString scriptLoadPath;
+
+	// Directory with natives_blob.bin and snapshot_blob.bin, empty when V8 is built without external startup data
+	QString v8DataPath;
+
+	// Startup snapshot with core library, default V8 snapshot is used when empty or stale
+	QString startupSnapshotPath;
+
+	// Keep one prepared context alive between runs instead of rebuilding it
+	bool persistentContext;
+
+	// Store compiled code of core library and loaded scripts next to their files
+	bool codeCache;
+
+	// Heap available to scripts in MB, 0 for V8 default, at most 512 in 32-bit build
+	int maxHeapSize;
+
+	// Wall-clock time limit of one run in ms, 0 for no limit
+	int maxRunTime;
+
+	// Engines used by Parallel module, 0 for one per processor core, negative disables it
+	int workerCount;
+
+	// Threads running async natives, 0 for one per processor core
+	int asyncThreadCount;
+
+	// Memory for values of Cache module in MB
+	int maxCacheSize;
+
+	// Directory holding copy of every Cache value, values are kept only in memory when empty
+	QString cacheDirectory;
+
+	// Count calls, data sizes and latency of natives, can be switched later by the engine
+	bool nativeStatistics;
+
+	// Directory with results of earlier runs, identical run returns stored result, empty disables it
+	QString resultCacheDirectory;
+
+	// Disk space for stored results in MB, least recently used results are removed above it
+	int maxResultCacheSize;
+
+	// Run scripts even when their result is stored, new results still replace stored ones, can be switched later by the engine
+	bool resultCacheBypassed;
+
+	// Register Bench.callLegacy and Bench.callBound measuring native call overhead, used by cwb-cli --benchmark-binding
+	bool bindingProbes;
 };
 
 #endif // ENVIRONMENT_H
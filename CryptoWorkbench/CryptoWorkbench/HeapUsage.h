@@ -0,0 +1,43 @@
+#ifndef HEAPUSAGE_H
+#define HEAPUSAGE_H
+
+#include <QString>
+#include <QList>
+#include <QMetaType>
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Structure holding heap statistics of engine at one point in time, sizes in bytes
+///
+////////////////////////////////////////////////////////////////////////////////////
+struct HeapUsage
+{
+	struct Space
+	{
+		Space() : size(0), usedSize(0), availableSize(0) {}
+
+		QString name;
+		size_t size;
+		size_t usedSize;
+		size_t availableSize;
+	};
+
+	HeapUsage() : totalHeapSize(0), usedHeapSize(0), heapSizeLimit(0), externalSize(0), peakUsedHeapSize(0), peakExternalSize(0) {}
+
+	size_t totalHeapSize;
+	size_t usedHeapSize;
+	size_t heapSizeLimit;
+
+	// Memory of ArrayBuffers living outside V8 heap
+	size_t externalSize;
+
+	// Highest used heap and ArrayBuffer memory since last run started
+	size_t peakUsedHeapSize;
+	size_t peakExternalSize;
+
+	QList<Space> spaces;
+};
+
+Q_DECLARE_METATYPE(HeapUsage)
+
+#endif // HEAPUSAGE_H
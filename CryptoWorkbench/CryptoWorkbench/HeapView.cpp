@@ -0,0 +1,82 @@
+#include "HeapView.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QFileDialog>
+
+// Columns of heap table
+enum HeapColumn
+{
+	ColumnName,
+	ColumnBefore,
+	ColumnAfter,
+	ColumnDelta,
+	ColumnCount,
+};
+
+static QString formatSize(double bytes)
+{
+	return QString::number(bytes / 1024.0, 'f', 1);
+}
+
+
+HeapView::HeapView(QWidget* parent)
+	: QWidget(parent)
+{
+	QVBoxLayout* layout = new QVBoxLayout(this);
+	QHBoxLayout* toolbarLayout = new QHBoxLayout();
+
+	usageTree = new QTreeWidget(this);
+	usageTree->setColumnCount(ColumnCount);
+	usageTree->setHeaderLabels(QStringList() << "Heap" << "Before KB" << "After KB" << "Delta KB");
+	usageTree->setRootIsDecorated(false);
+	usageTree->setUniformRowHeights(true);
+	usageTree->header()->setStretchLastSection(false);
+	usageTree->header()->setSectionResizeMode(ColumnName, QHeaderView::Stretch);
+
+	buttonSnapshot = new QPushButton("S&napshot...", this);
+	buttonSnapshot->setMinimumHeight(30);
+	connect(buttonSnapshot, &QPushButton::clicked, this, &HeapView::snapshotClicked);
+	toolbarLayout->addStretch(1);
+	toolbarLayout->addWidget(buttonSnapshot);
+
+	layout->setMargin(0);
+	layout->addLayout(toolbarLayout);
+	layout->addWidget(usageTree);
+}
+
+void HeapView::setHeapUsage(const HeapUsage& before, const HeapUsage& after)
+{
+	usageTree->clear();
+
+	addRow("Used heap", before.usedHeapSize, after.usedHeapSize);
+	addRow("Total heap", before.totalHeapSize, after.totalHeapSize);
+	addRow("External (ArrayBuffers)", before.externalSize, after.externalSize);
+
+	// Spaces are reported in the same order every time
+	for (int i = 0; i < after.spaces.count(); i++) {
+		size_t beforeSize = i < before.spaces.count() ? before.spaces.at(i).usedSize : 0;
+		addRow(after.spaces.at(i).name, beforeSize, after.spaces.at(i).usedSize);
+	}
+}
+
+void HeapView::snapshotClicked()
+{
+	QString fileName = QFileDialog::getSaveFileName(this, tr("Save Heap Snapshot"), "../scripts/", tr("Heap Snapshots (*.heapsnapshot)"));
+	if (!fileName.isEmpty())
+		emit snapshotRequested(fileName);
+}
+
+void HeapView::addRow(const QString& name, size_t before, size_t after)
+{
+	QTreeWidgetItem* item = new QTreeWidgetItem();
+	item->setText(ColumnName, name);
+	item->setText(ColumnBefore, formatSize(double(before)));
+	item->setText(ColumnAfter, formatSize(double(after)));
+	item->setText(ColumnDelta, formatSize(double(after) - double(before)));
+	for (int column = ColumnBefore; column <= ColumnDelta; column++)
+		item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+	usageTree->addTopLevelItem(item);
+}
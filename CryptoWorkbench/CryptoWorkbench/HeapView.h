@@ -0,0 +1,38 @@
+#ifndef HEAPVIEW_H
+#define HEAPVIEW_H
+
+#include <QWidget>
+#include "HeapUsage.h"
+
+class QTreeWidget;
+class QPushButton;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Side panel comparing heap statistics before and after last run
+///
+////////////////////////////////////////////////////////////////////////////////////
+class HeapView : public QWidget
+{
+	Q_OBJECT
+
+public:
+	HeapView(QWidget* parent = 0);
+
+	void setHeapUsage(const HeapUsage& before, const HeapUsage& after);
+
+signals:
+	void snapshotRequested(const QString& filePath);
+
+private slots:
+	void snapshotClicked();
+
+private:
+	void addRow(const QString& name, size_t before, size_t after);
+
+private:
+	QTreeWidget* usageTree;
+	QPushButton* buttonSnapshot;
+};
+
+#endif // HEAPVIEW_H
@@ -1,17 +1,162 @@
 #include "JavascriptInterface.h"
 #include "WorkbenchEngine.h"
+#include <QThread>
+#include <QElapsedTimer>
 
 JavascriptInterface::JavascriptInterface(const Environment& environment, QObject* parent)
+	: isEvaluationRunning(false), QObject(parent)
 {
+	qRegisterMetaType<ScriptResult>("ScriptResult");
+	qRegisterMetaType<ScriptProfile>("ScriptProfile");
+	qRegisterMetaType<HeapUsage>("HeapUsage");
+	qRegisterMetaType<QVector<qint64> >("QVector<qint64>");
+	qRegisterMetaType<QList<NativeStatistics::Counter> >("QList<NativeStatistics::Counter>");
+
 	engine = new WorkbenchEngine(environment);
+
+	// Engine is used only from engine thread, worker is deleted when thread finishes
+	engineThread = new QThread(this);
+	JavascriptWorker* worker = new JavascriptWorker(engine);
+	worker->moveToThread(engineThread);
+	engine->setOutputSink(worker);
+
+	connect(engineThread, &QThread::finished, worker, &QObject::deleteLater);
+	connect(this, &JavascriptInterface::evaluationRequested, worker, &JavascriptWorker::evaluate);
+	connect(this, &JavascriptInterface::cellEvaluationRequested, worker, &JavascriptWorker::evaluateCells);
+	connect(this, &JavascriptInterface::resetRequested, worker, &JavascriptWorker::reset);
+	connect(this, &JavascriptInterface::heapSnapshotRequested, worker, &JavascriptWorker::writeHeapSnapshot);
+	connect(this, &JavascriptInterface::nativeStatisticsRequested, worker, &JavascriptWorker::setNativeStatisticsEnabled);
+	connect(this, &JavascriptInterface::resultCacheBypassRequested, worker, &JavascriptWorker::setResultCacheBypassed);
+	connect(worker, &JavascriptWorker::finished, this, &JavascriptInterface::workerFinished);
+	connect(worker, &JavascriptWorker::profiled, this, &JavascriptInterface::profileFinished);
+	connect(worker, &JavascriptWorker::heapMeasured, this, &JavascriptInterface::heapUsageMeasured);
+	connect(worker, &JavascriptWorker::heapSnapshotWritten, this, &JavascriptInterface::heapSnapshotFinished);
+	connect(worker, &JavascriptWorker::outputWritten, this, &JavascriptInterface::outputWritten);
+	connect(worker, &JavascriptWorker::cellsEvaluated, this, &JavascriptInterface::cellsFinished);
+	connect(worker, &JavascriptWorker::nativesMeasured, this, &JavascriptInterface::nativeStatisticsMeasured);
+
+	engineThread->start();
 }
 
 JavascriptInterface::~JavascriptInterface()
 {
+	stop();
+	engineThread->quit();
+	engineThread->wait();
 	delete engine;
 }
 
-ScriptResult JavascriptInterface::evaluate(const QString& scriptText, const QString& workspaceText)
+void JavascriptInterface::evaluate(const QString& scriptText, const QString& workspaceText, bool isProfiled)
+{
+	isEvaluationRunning = true;
+	emit evaluationRequested(scriptText, workspaceText, isProfiled);
+}
+
+void JavascriptInterface::evaluateCells(const QString& scriptText, const QString& workspaceText)
+{
+	isEvaluationRunning = true;
+	emit cellEvaluationRequested(scriptText, workspaceText);
+}
+
+void JavascriptInterface::stop()
+{
+	if (isEvaluationRunning)
+		engine->terminate();
+}
+
+void JavascriptInterface::resetEngine()
+{
+	emit resetRequested();
+}
+
+BufferAllocator::Statistics JavascriptInterface::allocatorStatistics() const
+{
+	return engine->allocatorStatistics();
+}
+
+void JavascriptInterface::writeHeapSnapshot(const QString& filePath)
+{
+	emit heapSnapshotRequested(filePath);
+}
+
+void JavascriptInterface::setNativeStatisticsEnabled(bool isEnabled)
+{
+	emit nativeStatisticsRequested(isEnabled);
+}
+
+void JavascriptInterface::setResultCacheBypassed(bool isBypassed)
+{
+	emit resultCacheBypassRequested(isBypassed);
+}
+
+void JavascriptInterface::workerFinished(const ScriptResult& result, qint64 runtime)
+{
+	// Stop pressed while result was on its way must not end the next run
+	engine->cancelPendingStop();
+	isEvaluationRunning = false;
+	emit evaluationFinished(result, runtime);
+}
+
+void JavascriptWorker::evaluate(const QString& scriptText, const QString& workspaceText, bool isProfiled)
+{
+	ScriptProfile profile;
+
+	QElapsedTimer timer;
+	timer.start();
+	ScriptResult result = engine->evaluate(scriptText, workspaceText, isProfiled ? &profile : NULL);
+	qint64 runtime = timer.elapsed();
+
+	if (isProfiled)
+		emit profiled(profile);
+	reportNatives();
+	emit heapMeasured(engine->heapUsageBefore(), engine->heapUsageAfter());
+	emit finished(result, runtime);
+}
+
+void JavascriptWorker::evaluateCells(const QString& scriptText, const QString& workspaceText)
+{
+	QVector<qint64> cellTimes;
+
+	QElapsedTimer timer;
+	timer.start();
+	ScriptResult result = engine->evaluateCells(ScriptCell::split(scriptText), workspaceText, &cellTimes);
+	qint64 runtime = timer.elapsed();
+
+	emit cellsEvaluated(cellTimes);
+	reportNatives();
+	emit heapMeasured(engine->heapUsageBefore(), engine->heapUsageAfter());
+	emit finished(result, runtime);
+}
+
+bool JavascriptWorker::write(const QString& chunk)
+{
+	emit outputWritten(chunk);
+	return true;
+}
+
+void JavascriptWorker::reset()
+{
+	engine->reset();
+}
+
+void JavascriptWorker::writeHeapSnapshot(const QString& filePath)
+{
+	emit heapSnapshotWritten(filePath, engine->writeHeapSnapshot(filePath));
+}
+
+void JavascriptWorker::setNativeStatisticsEnabled(bool isEnabled)
+{
+	engine->setNativeStatisticsEnabled(isEnabled);
+}
+
+void JavascriptWorker::setResultCacheBypassed(bool isBypassed)
+{
+	engine->setResultCacheBypassed(isBypassed);
+}
+
+void JavascriptWorker::reportNatives()
 {
-	return engine->evaluate(scriptText, workspaceText);
+	// Script may have switched collection itself
+	if (engine->nativeStatistics() != NULL)
+		emit nativesMeasured(engine->nativeStatistics()->counters());
 }
@@ -3,14 +3,22 @@
 
 #include <QString>
 #include <QObject>
+#include <QVector>
 #include "ScriptResult.h"
 #include "Environment.h"
+#include "BufferAllocator.h"
+#include "ScriptProfile.h"
+#include "HeapUsage.h"
+#include "OutputSink.h"
+#include "NativeStatistics.h"
 
 class WorkbenchEngine;
+class QThread;
 
 ////////////////////////////////////////////////////////////////////////////////////
 ///
 /// Class wrapping WorkbenchEngine
+/// Scripts are evaluated on dedicated engine thread
 ///
 ////////////////////////////////////////////////////////////////////////////////////
 class JavascriptInterface : public QObject
@@ -21,8 +29,98 @@ public:
 	JavascriptInterface(const Environment& environment, QObject* parent = NULL);
 	~JavascriptInterface();
 
-	// Run javascript
-	ScriptResult evaluate(const QString& scriptText, const QString& workspaceText = QString());
+	// Run javascript, result is reported by evaluationFinished signal
+	// Profiled run reports CPU profile by profileFinished signal before finishing
+	void evaluate(const QString& scriptText, const QString& workspaceText = QString(), bool isProfiled = false);
+
+	// Run script split into cells, only cells from the first changed one run
+	// Cell runtimes are reported by cellsFinished signal before evaluationFinished
+	void evaluateCells(const QString& scriptText, const QString& workspaceText = QString());
+
+	// Abort running script, state kept by engine is preserved
+	void stop();
+
+	// Discard state kept between runs
+	void resetEngine();
+
+	bool isRunning() const { return isEvaluationRunning; }
+
+	// Counters of engine ArrayBuffer allocator
+	BufferAllocator::Statistics allocatorStatistics() const;
+
+	// Write heap snapshot after running script finishes, reported by heapSnapshotFinished signal
+	void writeHeapSnapshot(const QString& filePath);
+
+	// Native counters are reported by nativeStatisticsMeasured signal after every run while enabled
+	void setNativeStatisticsEnabled(bool isEnabled);
+
+	// Run scripts again even when their result is cached, takes effect from next run
+	void setResultCacheBypassed(bool isBypassed);
+
+signals:
+	void evaluationFinished(const ScriptResult& result, qint64 runtime);
+	void profileFinished(const ScriptProfile& profile);
+	void heapUsageMeasured(const HeapUsage& before, const HeapUsage& after);
+	void heapSnapshotFinished(const QString& filePath, bool isWritten);
+
+	// Text written by running script through Output, arrives before evaluationFinished
+	void outputWritten(const QString& chunk);
+	void cellsFinished(const QVector<qint64>& cellTimes);
+	void nativeStatisticsMeasured(const QList<NativeStatistics::Counter>& counters);
+
+	// Requests delivered to engine thread
+	void evaluationRequested(const QString& scriptText, const QString& workspaceText, bool isProfiled);
+	void cellEvaluationRequested(const QString& scriptText, const QString& workspaceText);
+	void resetRequested();
+	void heapSnapshotRequested(const QString& filePath);
+	void nativeStatisticsRequested(bool isEnabled);
+	void resultCacheBypassRequested(bool isBypassed);
+
+private slots:
+	void workerFinished(const ScriptResult& result, qint64 runtime);
+
+private:
+	WorkbenchEngine* engine;
+	QThread* engineThread;
+	bool isEvaluationRunning;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Object living in engine thread, calls WorkbenchEngine
+/// Used internally by JavascriptInterface
+///
+////////////////////////////////////////////////////////////////////////////////////
+class JavascriptWorker : public QObject, public OutputSink
+{
+	Q_OBJECT
+
+public:
+	JavascriptWorker(WorkbenchEngine* workbenchEngine) : engine(workbenchEngine) {}
+
+	// Script output is forwarded to GUI thread by outputWritten signal
+	virtual bool write(const QString& chunk);
+
+public slots:
+	void evaluate(const QString& scriptText, const QString& workspaceText, bool isProfiled);
+	void evaluateCells(const QString& scriptText, const QString& workspaceText);
+	void reset();
+	void writeHeapSnapshot(const QString& filePath);
+	void setNativeStatisticsEnabled(bool isEnabled);
+	void setResultCacheBypassed(bool isBypassed);
+
+signals:
+	void finished(const ScriptResult& result, qint64 runtime);
+	void profiled(const ScriptProfile& profile);
+	void heapMeasured(const HeapUsage& before, const HeapUsage& after);
+	void heapSnapshotWritten(const QString& filePath, bool isWritten);
+	void outputWritten(const QString& chunk);
+	void cellsEvaluated(const QVector<qint64>& cellTimes);
+	void nativesMeasured(const QList<NativeStatistics::Counter>& counters);
+
+private:
+	void reportNatives();
 
 private:
 	WorkbenchEngine* engine;
@@ -0,0 +1,187 @@
+#include "JobQueue.h"
+#include "JavascriptInterface.h"
+
+JobQueue::JobQueue(const Environment& engineEnvironment, int engineCount, QObject* parent)
+	: QObject(parent), environment(engineEnvironment), maxEngineCount(qMax(1, engineCount)), lastJobId(0)
+{
+	// Jobs don't share state, each run starts from clean context
+	environment.persistentContext = false;
+}
+
+JobQueue::~JobQueue()
+{
+	qDeleteAll(engines);
+	qDeleteAll(jobs);
+}
+
+int JobQueue::enqueue(const QString& name, const QString& scriptText, const QString& workspaceText, int priority)
+{
+	Job* job = new Job();
+	job->id = ++lastJobId;
+	job->name = name;
+	job->priority = priority;
+	job->scriptText = scriptText;
+	job->workspaceText = workspaceText;
+	jobs.append(job);
+
+	emit jobChanged(job->id);
+	startJobs();
+	return job->id;
+}
+
+void JobQueue::cancel(int id)
+{
+	Job* job = findJob(id);
+	if (job == NULL)
+		return;
+
+	// Running job is marked cancelled when its engine finishes
+	if (job->status == Job::StatusRunning) {
+		JavascriptInterface* engine = runningJobs.key(job);
+		if (engine != NULL)
+			engine->stop();
+		job->status = Job::StatusCancelled;
+	}
+	else if (job->status == Job::StatusQueued) {
+		job->status = Job::StatusCancelled;
+		emit jobChanged(id);
+	}
+}
+
+void JobQueue::setResultCacheBypassed(bool isBypassed)
+{
+	// Engines created later take the setting from environment
+	environment.resultCacheBypassed = isBypassed;
+	foreach (JavascriptInterface* engine, engines)
+		engine->setResultCacheBypassed(isBypassed);
+}
+
+void JobQueue::remove(int id)
+{
+	for (int i = 0; i < jobs.count(); i++) {
+		if (jobs.at(i)->id == id && runningJobs.key(jobs.at(i)) == NULL) {
+			delete jobs.takeAt(i);
+			emit jobChanged(id);
+			return;
+		}
+	}
+}
+
+const JobQueue::Job* JobQueue::job(int id) const
+{
+	return findJob(id);
+}
+
+qint64 JobQueue::elapsed(int id) const
+{
+	Job* job = findJob(id);
+	if (job == NULL)
+		return 0;
+	return runningJobs.key(job) != NULL ? job->timer.elapsed() : job->runtime;
+}
+
+JobQueue::Job* JobQueue::findJob(int id) const
+{
+	foreach (Job* job, jobs) {
+		if (job->id == id)
+			return job;
+	}
+	return NULL;
+}
+
+void JobQueue::setEngineCount(int count)
+{
+	maxEngineCount = qMax(1, count);
+
+	// Idle engines above the limit are dropped, busy ones after their job
+	for (int i = engines.count() - 1; i >= 0 && engines.count() > maxEngineCount; i--) {
+		if (!runningJobs.contains(engines.at(i)))
+			delete engines.takeAt(i);
+	}
+	startJobs();
+}
+
+JobQueue::Job* JobQueue::nextJob() const
+{
+	// Highest priority first, jobs with the same priority in order of arrival
+	Job* next = NULL;
+	foreach (Job* job, jobs) {
+		if (job->status == Job::StatusQueued && (next == NULL || job->priority > next->priority))
+			next = job;
+	}
+	return next;
+}
+
+void JobQueue::startJobs()
+{
+	while (runningJobs.count() < maxEngineCount) {
+		Job* job = nextJob();
+		if (job == NULL)
+			return;
+
+		JavascriptInterface* engine = idleEngine();
+		runningJobs.insert(engine, job);
+		job->status = Job::StatusRunning;
+		job->timer.start();
+		engine->evaluate(job->scriptText, job->workspaceText);
+		emit jobChanged(job->id);
+	}
+}
+
+JavascriptInterface* JobQueue::idleEngine()
+{
+	foreach (JavascriptInterface* engine, engines) {
+		if (!runningJobs.contains(engine))
+			return engine;
+	}
+
+	JavascriptInterface* engine = new JavascriptInterface(environment);
+	connect(engine, &JavascriptInterface::outputWritten, this, &JobQueue::engineOutputWritten);
+	connect(engine, &JavascriptInterface::heapUsageMeasured, this, &JobQueue::engineHeapMeasured);
+	connect(engine, &JavascriptInterface::evaluationFinished, this, &JobQueue::engineFinished);
+	engines.append(engine);
+	return engine;
+}
+
+JobQueue::Job* JobQueue::senderJob() const
+{
+	return runningJobs.value(qobject_cast<JavascriptInterface*>(sender()));
+}
+
+void JobQueue::engineOutputWritten(const QString& chunk)
+{
+	Job* job = senderJob();
+	if (job != NULL)
+		job->output.append(chunk);
+}
+
+void JobQueue::engineHeapMeasured(const HeapUsage& before, const HeapUsage& after)
+{
+	Q_UNUSED(before);
+
+	Job* job = senderJob();
+	if (job != NULL)
+		job->peakMemory = after.peakUsedHeapSize + after.peakExternalSize;
+}
+
+void JobQueue::engineFinished(const ScriptResult& result, qint64 runtime)
+{
+	JavascriptInterface* engine = qobject_cast<JavascriptInterface*>(sender());
+	Job* job = runningJobs.take(engine);
+	if (job != NULL) {
+		job->runtime = runtime;
+		job->result = result;
+		if (job->status != Job::StatusCancelled)
+			job->status = result.isValid() ? Job::StatusFinished : Job::StatusFailed;
+
+		// Input may be large, reopening needs only the result
+		job->workspaceText.clear();
+		emit jobChanged(job->id);
+	}
+
+	if (engines.count() > maxEngineCount) {
+		engines.removeOne(engine);
+		engine->deleteLater();
+	}
+	startJobs();
+}
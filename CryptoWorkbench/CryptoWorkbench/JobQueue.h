@@ -0,0 +1,106 @@
+#ifndef JOBQUEUE_H
+#define JOBQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QElapsedTimer>
+#include "ScriptResult.h"
+#include "Environment.h"
+#include "HeapUsage.h"
+
+class JavascriptInterface;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Queue of scripts run in background by pool of engines
+/// Jobs with higher priority start first, finished jobs keep their results
+///
+////////////////////////////////////////////////////////////////////////////////////
+class JobQueue : public QObject
+{
+	Q_OBJECT
+
+public:
+	struct Job
+	{
+		enum Status
+		{
+			StatusQueued,
+			StatusRunning,
+			StatusFinished,
+			StatusFailed,
+			StatusCancelled,
+		};
+
+		Job() : id(0), priority(0), status(StatusQueued), runtime(0), peakMemory(0) {}
+
+		int id;
+		QString name;
+		int priority;
+		QString scriptText;
+		QString workspaceText;
+		Status status;
+
+		// Runtime in ms, measured while job runs
+		qint64 runtime;
+		QElapsedTimer timer;
+
+		// Peak of used heap and ArrayBuffers in bytes
+		size_t peakMemory;
+
+		// Text streamed through Output followed by script result
+		QString output;
+		ScriptResult result;
+	};
+
+	JobQueue(const Environment& engineEnvironment, int engineCount, QObject* parent = NULL);
+	~JobQueue();
+
+	// Add job, returns its id
+	int enqueue(const QString& name, const QString& scriptText, const QString& workspaceText, int priority);
+
+	// Queued job is dropped, running job is stopped
+	void cancel(int id);
+
+	// Forget job which is not running
+	void remove(int id);
+
+	// Returns NULL for unknown id, pointer is valid until job is removed
+	const Job* job(int id) const;
+
+	// Runtime of finished job or time since running job started, in ms
+	qint64 elapsed(int id) const;
+
+	// Maximum number of jobs running at once, engines are created when needed
+	void setEngineCount(int count);
+	int engineCount() const { return maxEngineCount; }
+
+	// Run jobs even when their result is cached, takes effect from next job
+	void setResultCacheBypassed(bool isBypassed);
+
+signals:
+	void jobChanged(int id);
+
+private slots:
+	void engineOutputWritten(const QString& chunk);
+	void engineHeapMeasured(const HeapUsage& before, const HeapUsage& after);
+	void engineFinished(const ScriptResult& result, qint64 runtime);
+
+private:
+	Job* findJob(int id) const;
+	Job* nextJob() const;
+	void startJobs();
+	JavascriptInterface* idleEngine();
+	Job* senderJob() const;
+
+private:
+	Environment environment;
+	int maxEngineCount;
+	int lastJobId;
+	QList<Job*> jobs;
+	QList<JavascriptInterface*> engines;
+	QHash<JavascriptInterface*, Job*> runningJobs;
+};
+
+#endif // JOBQUEUE_H
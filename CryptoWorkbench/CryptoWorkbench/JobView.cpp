@@ -0,0 +1,200 @@
+#include "JobView.h"
+#include "JobQueue.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QLabel>
+#include <QTimer>
+
+// Columns of job table
+enum JobColumn
+{
+	ColumnName,
+	ColumnPriority,
+	ColumnStatus,
+	ColumnTime,
+	ColumnMemory,
+	ColumnCount,
+};
+
+// Interval of elapsed time updates of running jobs in ms
+static const int RefreshInterval = 500;
+
+static QString statusName(JobQueue::Job::Status status)
+{
+	switch (status) {
+		case JobQueue::Job::StatusQueued:
+			return "Queued";
+		case JobQueue::Job::StatusRunning:
+			return "Running";
+		case JobQueue::Job::StatusFinished:
+			return "Finished";
+		case JobQueue::Job::StatusFailed:
+			return "Failed";
+		case JobQueue::Job::StatusCancelled:
+			return "Cancelled";
+	}
+	return QString();
+}
+
+
+JobView::JobView(JobQueue* queue, QWidget* parent)
+	: QWidget(parent), jobQueue(queue)
+{
+	QVBoxLayout* layout = new QVBoxLayout(this);
+	QHBoxLayout* toolbarLayout = new QHBoxLayout();
+
+	jobTree = new QTreeWidget(this);
+	jobTree->setColumnCount(ColumnCount);
+	jobTree->setHeaderLabels(QStringList() << "Job" << "Priority" << "Status" << "Time ms" << "Peak MB");
+	jobTree->setRootIsDecorated(false);
+	jobTree->setUniformRowHeights(true);
+	jobTree->header()->setStretchLastSection(false);
+	jobTree->header()->setSectionResizeMode(ColumnName, QHeaderView::Stretch);
+	connect(jobTree, &QTreeWidget::itemActivated, this, &JobView::itemActivated);
+
+	prioritySpin = new QSpinBox(this);
+	prioritySpin->setRange(-99, 99);
+	prioritySpin->setToolTip("Priority of queued jobs, higher runs first");
+
+	engineCountSpin = new QSpinBox(this);
+	engineCountSpin->setRange(1, 64);
+	engineCountSpin->setValue(jobQueue->engineCount());
+	engineCountSpin->setToolTip("Number of jobs running at once");
+	connect(engineCountSpin, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &JobView::engineCountChanged);
+
+	QPushButton* buttonOpen = new QPushButton("Op&en", this);
+	buttonOpen->setMinimumHeight(30);
+	connect(buttonOpen, &QPushButton::clicked, this, &JobView::openClicked);
+
+	QPushButton* buttonCancel = new QPushButton("Ca&ncel", this);
+	buttonCancel->setMinimumHeight(30);
+	connect(buttonCancel, &QPushButton::clicked, this, &JobView::cancelClicked);
+
+	QPushButton* buttonRemove = new QPushButton("Re&move", this);
+	buttonRemove->setMinimumHeight(30);
+	connect(buttonRemove, &QPushButton::clicked, this, &JobView::removeClicked);
+
+	toolbarLayout->addWidget(new QLabel("Priority", this));
+	toolbarLayout->addWidget(prioritySpin);
+	toolbarLayout->addWidget(new QLabel("Engines", this));
+	toolbarLayout->addWidget(engineCountSpin);
+	toolbarLayout->addStretch(1);
+	toolbarLayout->addWidget(buttonOpen);
+	toolbarLayout->addWidget(buttonCancel);
+	toolbarLayout->addWidget(buttonRemove);
+
+	layout->setMargin(0);
+	layout->addLayout(toolbarLayout);
+	layout->addWidget(jobTree);
+
+	refreshTimer = new QTimer(this);
+	refreshTimer->setInterval(RefreshInterval);
+	connect(refreshTimer, &QTimer::timeout, this, &JobView::refreshRunning);
+	connect(jobQueue, &JobQueue::jobChanged, this, &JobView::jobChanged);
+}
+
+int JobView::priority() const
+{
+	return prioritySpin->value();
+}
+
+void JobView::jobChanged(int id)
+{
+	QTreeWidgetItem* item = findItem(id);
+	if (jobQueue->job(id) == NULL) {
+		delete item;
+		return;
+	}
+
+	if (item == NULL) {
+		item = new QTreeWidgetItem(jobTree);
+		item->setData(ColumnName, Qt::UserRole, id);
+		item->setTextAlignment(ColumnPriority, Qt::AlignRight | Qt::AlignVCenter);
+		item->setTextAlignment(ColumnTime, Qt::AlignRight | Qt::AlignVCenter);
+		item->setTextAlignment(ColumnMemory, Qt::AlignRight | Qt::AlignVCenter);
+	}
+	updateItem(item, id);
+
+	// Timer runs only while some job is running
+	if (jobQueue->job(id)->status == JobQueue::Job::StatusRunning)
+		refreshTimer->start();
+}
+
+void JobView::refreshRunning()
+{
+	bool isAnyRunning = false;
+	for (int i = 0; i < jobTree->topLevelItemCount(); i++) {
+		QTreeWidgetItem* item = jobTree->topLevelItem(i);
+		int id = item->data(ColumnName, Qt::UserRole).toInt();
+		const JobQueue::Job* job = jobQueue->job(id);
+		if (job != NULL && job->status == JobQueue::Job::StatusRunning) {
+			updateItem(item, id);
+			isAnyRunning = true;
+		}
+	}
+
+	if (!isAnyRunning)
+		refreshTimer->stop();
+}
+
+void JobView::engineCountChanged(int count)
+{
+	jobQueue->setEngineCount(count);
+}
+
+void JobView::openClicked()
+{
+	int id = selectedJob();
+	if (id != 0)
+		emit openRequested(id);
+}
+
+void JobView::cancelClicked()
+{
+	int id = selectedJob();
+	if (id != 0)
+		jobQueue->cancel(id);
+}
+
+void JobView::removeClicked()
+{
+	int id = selectedJob();
+	if (id != 0)
+		jobQueue->remove(id);
+}
+
+void JobView::itemActivated(QTreeWidgetItem* item)
+{
+	emit openRequested(item->data(ColumnName, Qt::UserRole).toInt());
+}
+
+QTreeWidgetItem* JobView::findItem(int id) const
+{
+	for (int i = 0; i < jobTree->topLevelItemCount(); i++) {
+		if (jobTree->topLevelItem(i)->data(ColumnName, Qt::UserRole).toInt() == id)
+			return jobTree->topLevelItem(i);
+	}
+	return NULL;
+}
+
+int JobView::selectedJob() const
+{
+	QTreeWidgetItem* item = jobTree->currentItem();
+	return item != NULL ? item->data(ColumnName, Qt::UserRole).toInt() : 0;
+}
+
+void JobView::updateItem(QTreeWidgetItem* item, int id)
+{
+	const JobQueue::Job* job = jobQueue->job(id);
+
+	item->setText(ColumnName, job->name);
+	item->setText(ColumnPriority, QString::number(job->priority));
+	item->setText(ColumnStatus, statusName(job->status));
+	item->setText(ColumnTime, job->status == JobQueue::Job::StatusQueued ? QString() : QString::number(jobQueue->elapsed(id)));
+	item->setText(ColumnMemory, job->peakMemory > 0 ? QString::number(job->peakMemory / (1024.0 * 1024.0), 'f', 1) : QString());
+	item->setToolTip(ColumnStatus, job->status == JobQueue::Job::StatusFailed ? job->result.data() : QString());
+}
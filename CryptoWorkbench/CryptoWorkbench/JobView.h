@@ -0,0 +1,53 @@
+#ifndef JOBVIEW_H
+#define JOBVIEW_H
+
+#include <QWidget>
+
+class JobQueue;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QSpinBox;
+class QPushButton;
+class QTimer;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Side panel listing queued, running and finished jobs of JobQueue
+///
+////////////////////////////////////////////////////////////////////////////////////
+class JobView : public QWidget
+{
+	Q_OBJECT
+
+public:
+	JobView(JobQueue* queue, QWidget* parent = 0);
+
+	// Priority chosen for newly queued jobs
+	int priority() const;
+
+signals:
+	void openRequested(int id);
+
+private slots:
+	void jobChanged(int id);
+	void refreshRunning();
+	void engineCountChanged(int count);
+	void openClicked();
+	void cancelClicked();
+	void removeClicked();
+	void itemActivated(QTreeWidgetItem* item);
+
+private:
+	QTreeWidgetItem* findItem(int id) const;
+	int selectedJob() const;
+	void updateItem(QTreeWidgetItem* item, int id);
+
+private:
+	JobQueue* jobQueue;
+	QTreeWidget* jobTree;
+	QSpinBox* prioritySpin;
+	QSpinBox* engineCountSpin;
+	QTimer* refreshTimer;
+};
+
+#endif // JOBVIEW_H
@@ -0,0 +1,289 @@
+#include "ModuleBench.h"
+#include "WorkbenchEngine.h"
+#include "Utility.h"
+#include "NativeBinding.h"
+#include <QVector>
+#include <QPair>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+using namespace v8;
+
+// Samples shorter than this are dominated by clock overhead, calls are batched until they reach it
+static const qint64 MinSampleTime = 20000;
+
+static const int DefaultIterations = 100;
+static const int DefaultWarmup = 10;
+
+
+struct BenchOptions
+{
+	BenchOptions() : iterations(DefaultIterations), warmup(DefaultWarmup), batch(0), bytes(0.0) {}
+
+	int iterations;
+	int warmup;
+	int batch;
+	double bytes;
+};
+
+// Per call times in nanoseconds
+struct BenchSamples
+{
+	BenchSamples() : batch(1) {}
+
+	QVector<double> times;
+	int batch;
+};
+
+static double percentile(const QVector<double>& sortedTimes, double fraction)
+{
+	int rank = static_cast<int>(std::ceil(fraction * sortedTimes.count())) - 1;
+	return sortedTimes.at(qBound(0, rank, sortedTimes.count() - 1));
+}
+
+// Getter of option may throw, exception is left pending
+static bool readIntOption(Isolate* isolate, Local<Object> object, const char* name, int minimum, int* value, bool* isValid)
+{
+	Local<Value> option;
+	if (!object->Get(isolate->GetCurrentContext(), String::NewFromUtf8(isolate, name)).ToLocal(&option))
+		return false;
+	if (option->IsUndefined())
+		return true;
+	if (!option->IsInt32() || option->Int32Value() < minimum)
+		*isValid = false;
+	else
+		*value = option->Int32Value();
+	return true;
+}
+
+// Returns false with exception thrown when options can't be read or hold invalid value
+static bool readOptions(Isolate* isolate, Local<Value> value, BenchOptions* options)
+{
+	if (value->IsUndefined())
+		return true;
+	if (!value->IsObject()) {
+		Utility::throwException(isolate, Utility::ExceptionInvalidArgumentValue);
+		return false;
+	}
+
+	Local<Object> object = Local<Object>::Cast(value);
+	bool isValid = true;
+	if (!readIntOption(isolate, object, "iterations", 1, &options->iterations, &isValid) ||
+		!readIntOption(isolate, object, "warmup", 0, &options->warmup, &isValid) ||
+		!readIntOption(isolate, object, "batch", 1, &options->batch, &isValid))
+		return false;
+
+	Local<Value> bytes;
+	if (!object->Get(isolate->GetCurrentContext(), String::NewFromUtf8(isolate, "bytes")).ToLocal(&bytes))
+		return false;
+	if (!bytes->IsUndefined()) {
+		if (!bytes->IsNumber() || bytes->NumberValue() < 0)
+			isValid = false;
+		else
+			options->bytes = bytes->NumberValue();
+	}
+
+	if (!isValid)
+		Utility::throwException(isolate, Utility::ExceptionInvalidArgumentValue);
+	return isValid;
+}
+
+// Returns nanoseconds spent by batch of calls, negative when function threw or script was stopped
+static qint64 runBatch(Isolate* isolate, Local<Function> function, int batch)
+{
+	Local<Context> context = isolate->GetCurrentContext();
+	Local<Value> receiver = Undefined(isolate);
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < batch; i++) {
+		HandleScope handle_scope(isolate);
+		if (function->Call(context, receiver, 0, NULL).IsEmpty())
+			return -1;
+	}
+	return timer.nsecsElapsed();
+}
+
+static bool measure(Isolate* isolate, Local<Function> function, const BenchOptions& options, BenchSamples* samples)
+{
+	// Timings differ between runs, result of benchmarking script is not cached
+	reinterpret_cast<WorkbenchEngine*>(isolate->GetData(Utility::DataSlotEngine))->preventResultCaching();
+
+	// Grow batch during warmup until one sample takes long enough to time reliably
+	samples->batch = options.batch > 0 ? options.batch : 1;
+	for (int i = 0; i < options.warmup || (options.batch == 0 && i == 0); i++) {
+		qint64 elapsed = runBatch(isolate, function, samples->batch);
+		if (elapsed < 0)
+			return false;
+		if (options.batch == 0 && elapsed < MinSampleTime && samples->batch < (1 << 24)) {
+			samples->batch *= 2;
+			i--;
+		}
+	}
+
+	samples->times.reserve(options.iterations);
+	for (int i = 0; i < options.iterations; i++) {
+		qint64 elapsed = runBatch(isolate, function, samples->batch);
+		if (elapsed < 0)
+			return false;
+		samples->times.append(double(elapsed) / samples->batch);
+	}
+	return true;
+}
+
+// Result object with times in microseconds
+static Local<Object> createResult(Isolate* isolate, const QString& name, BenchSamples& samples, const BenchOptions& options)
+{
+	EscapableHandleScope handle_scope(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+
+	QVector<double>& times = samples.times;
+	std::sort(times.begin(), times.end());
+
+	double total = 0.0;
+	for (int i = 0; i < times.count(); i++)
+		total += times.at(i);
+	double mean = total / times.count();
+	double median = percentile(times, 0.5);
+
+	Local<Object> result = Object::New(isolate);
+	result->Set(context, String::NewFromUtf8(isolate, "name"), Utility::toV8String(isolate, name)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "iterations"), Int32::New(isolate, times.count())).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "batch"), Int32::New(isolate, samples.batch)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "min"), Number::New(isolate, times.first() / 1000.0)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "median"), Number::New(isolate, median / 1000.0)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "mean"), Number::New(isolate, mean / 1000.0)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "p95"), Number::New(isolate, percentile(times, 0.95) / 1000.0)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "p99"), Number::New(isolate, percentile(times, 0.99) / 1000.0)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "max"), Number::New(isolate, times.last() / 1000.0)).FromJust();
+
+	// Throughput is based on median, outliers from garbage collection don't skew it
+	double opsPerSecond = median > 0.0 ? 1e9 / median : 0.0;
+	result->Set(context, String::NewFromUtf8(isolate, "opsPerSec"), Number::New(isolate, opsPerSecond)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "bytesPerSec"), Number::New(isolate, opsPerSecond * options.bytes)).FromJust();
+
+	return handle_scope.Escape(result);
+}
+
+void benchRun(const FunctionCallbackInfo<Value>& args)
+{
+	if (args.Length() < 1) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
+		return;
+	}
+	if (!args[0]->IsFunction()) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
+		return;
+	}
+
+	Isolate* isolate = args.GetIsolate();
+	HandleScope handle_scope(isolate);
+
+	BenchOptions options;
+	if (!readOptions(isolate, args[1], &options))
+		return;
+
+	Local<Function> function = Local<Function>::Cast(args[0]);
+	BenchSamples samples;
+	if (!measure(isolate, function, options, &samples))
+		return;
+
+	args.GetReturnValue().Set(createResult(isolate, Utility::toString(function->GetName()), samples, options));
+}
+
+void benchCompare(const FunctionCallbackInfo<Value>& args)
+{
+	if (args.Length() < 1) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
+		return;
+	}
+	if (!args[0]->IsObject()) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
+		return;
+	}
+
+	Isolate* isolate = args.GetIsolate();
+	HandleScope handle_scope(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+
+	BenchOptions options;
+	if (!readOptions(isolate, args[1], &options))
+		return;
+
+	Local<Object> variants = Local<Object>::Cast(args[0]);
+	Local<Array> names;
+	if (!variants->GetOwnPropertyNames(context).ToLocal(&names))
+		return;
+
+	// Measure every variant, results are ordered from fastest
+	QVector<QPair<double, int> > order;
+	QVector<Local<Object> > results;
+	for (uint32_t i = 0; i < names->Length(); i++) {
+		Local<Value> name;
+		Local<Value> variant;
+		if (!names->Get(context, i).ToLocal(&name) || !variants->Get(context, name).ToLocal(&variant))
+			return;
+		if (!variant->IsFunction()) {
+			Utility::throwException(isolate, QString("Variant is not a function: %1").arg(Utility::toString(name)));
+			return;
+		}
+
+		BenchSamples samples;
+		if (!measure(isolate, Local<Function>::Cast(variant), options, &samples))
+			return;
+
+		Local<Object> result = createResult(isolate, Utility::toString(name), samples, options);
+		order.append(qMakePair(result->Get(context, String::NewFromUtf8(isolate, "median")).ToLocalChecked()->NumberValue(), results.count()));
+		results.append(result);
+	}
+	std::sort(order.begin(), order.end());
+
+	Local<Array> resultArray = Array::New(isolate, results.count());
+	for (int i = 0; i < order.count(); i++) {
+		Local<Object> result = results.at(order.at(i).second);
+		double relative = order.first().first > 0.0 ? order.at(i).first / order.first().first : 1.0;
+		result->Set(context, String::NewFromUtf8(isolate, "relative"), Number::New(isolate, relative)).FromJust();
+		resultArray->Set(context, i, result).FromJust();
+	}
+
+	args.GetReturnValue().Set(resultArray);
+}
+
+// Call overhead probes doing the same work, hand-written callback against NativeBinding wrapper
+void benchCallLegacy(const FunctionCallbackInfo<Value>& args)
+{
+	if (args.Length() < 2) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
+		return;
+	}
+	if (!args[0]->IsString() || !args[1]->IsInt32()) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
+		return;
+	}
+
+	QString text = Utility::toString(args[0]);
+	QString result = text.left(args[1]->Int32Value());
+	NativeStatistics::addBytes(args.GetIsolate(), text.size() * sizeof(QChar), result.size() * sizeof(QChar));
+	args.GetReturnValue().Set(Utility::toV8String(args.GetIsolate(), result));
+}
+
+QString benchCallBound(NativeCall& call, const QString& text, int length)
+{
+	return text.left(length);
+}
+
+void ModuleBench::registerTemplates(Isolate* isolate, Local<ObjectTemplate> globalObject, bool hasBindingProbes)
+{
+	HandleScope handle_scope(isolate);
+	Local<ObjectTemplate> object = ObjectTemplate::New(isolate);
+
+	object->Set(String::NewFromUtf8(isolate, "run"), FunctionTemplate::New(isolate, benchRun));
+	object->Set(String::NewFromUtf8(isolate, "compare"), FunctionTemplate::New(isolate, benchCompare));
+	if (hasBindingProbes) {
+		object->Set(String::NewFromUtf8(isolate, "callLegacy"), NativeBinding::callback<benchCallLegacy>(isolate, "Bench.callLegacy"));
+		object->Set(String::NewFromUtf8(isolate, "callBound"), NativeBinding::function<decltype(&benchCallBound), &benchCallBound>(isolate, "Bench.callBound"));
+	}
+
+	globalObject->Set(String::NewFromUtf8(isolate, "Bench"), object);
+}
@@ -0,0 +1,21 @@
+#ifndef MODULEBENCH_H
+#define MODULEBENCH_H
+
+#include "include/v8.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Definitions for functions contained in javascript Bench object.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ModuleBench
+{
+public:
+	// Call overhead probes are registered only when requested
+	static void registerTemplates(v8::Isolate* isolate, v8::Local<v8::ObjectTemplate> globalObject, bool hasBindingProbes);
+
+private:
+	ModuleBench() {}
+};
+
+#endif // MODULEBENCH_H
@@ -1,180 +1,165 @@
 #include "ModuleByteArray.h"
 #include "Utility.h"
+#include "NativeBinding.h"
+#include "AsyncTasks.h"
 #include <QCryptographicHash>
 #include <QDebug>
 
 using namespace v8;
 
-static Global<ObjectTemplate> ByteArrayTemplate;
 
-
-QByteArray byteArrayFromString(const QString& source, int format)
+QByteArray byteArrayFromString(Isolate* isolate, Local<String> source, int format)
 {
+	if (format == 1) {
+		String::Utf8Value utf8(source);
+		return QByteArray(*utf8, utf8.length());
+	}
+
+	// Other formats are plain one byte text
+	Latin1String text;
+	NativeArgument<Latin1String>::convert(isolate, source, &text);
+
 	switch (format) {
-		case 1:
-			return source.toUtf8();
 		case 2:
-			return QByteArray::fromHex(source.toLatin1());
+			return QByteArray::fromHex(text.data);
 		case 3:
-			return QByteArray::fromBase64(source.toLatin1());
+			return QByteArray::fromBase64(text.data);
 	}
-	return source.toLatin1();
+	return text.data;
 }
 
-void constructByteArray(const FunctionCallbackInfo<Value>& args)
+// Data of ByteArray the method is called on, not copied
+QByteArray receiverData(NativeCall& call)
 {
-	if (!args.IsConstructCall()) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionMustCallAsConstructor);
-		return;
-	}
-	if (args.Length() == 0) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
-		return;
-	}
-
 	QByteArray data;
+	if (!NativeArgument<QByteArray>::convert(call.isolate(), call.holder(), &data))
+		call.fail("ByteArray.buffer must be ArrayBuffer");
+	return data;
+}
 
-	if (args[0]->IsArrayBuffer()) {
-		data = Utility::toByteArray(args[0]);
-	}
-	else if (args[0]->IsString()) {
-		int format = 0;
-		if (args.Length() >= 2 && args[1]->IsInt32())
-			format = args[1]->Int32Value();
-		if (format < 0 || format > 3) {
-			Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentValue);
-			return;
-		}
-		data = byteArrayFromString(Utility::toString(args[0]).toLatin1(), format);
+QByteArray constructByteArray(NativeCall& call, Local<Value> source, LenientOptional<int> format)
+{
+	if (!call.isConstructCall()) {
+		call.fail(Utility::ExceptionMustCallAsConstructor);
+		return QByteArray();
 	}
-	else {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-		return;
+
+	if (source->IsArrayBuffer())
+		return Utility::toByteArray(source);
+
+	if (!source->IsString()) {
+		call.fail(Utility::ExceptionInvalidArgumentType);
+		return QByteArray();
 	}
 
-	HandleScope handle_scope(args.GetIsolate());
+	int sourceFormat = format.valueOr(0);
+	if (sourceFormat < 0 || sourceFormat > 3) {
+		call.fail(Utility::ExceptionInvalidArgumentValue);
+		return QByteArray();
+	}
 
 	// Return the constructed object
-	args.GetReturnValue().Set(ModuleByteArray::wrapByteArray(args.GetIsolate(), data));
+	return byteArrayFromString(call.isolate(), Local<String>::Cast(source), sourceFormat);
 }
 
-void hex(const FunctionCallbackInfo<Value>& args)
+Latin1String hex(NativeCall& call, LenientOptional<int> format)
 {
-	QByteArray data = ModuleByteArray::unwrapByteArray(args.GetIsolate(), args.Holder());
-
-	int format = 0;
-	if (args.Length() >= 1 && args[0]->IsInt32())
-		format = args[0]->Int32Value();
-	if (format < 0 || format > 2) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentValue);
-		return;
+	QByteArray data = receiverData(call);
+	if (call.isFailed())
+		return Latin1String();
+
+	int hexFormat = format.valueOr(0);
+	if (hexFormat < 0 || hexFormat > 2) {
+		call.fail(Utility::ExceptionInvalidArgumentValue);
+		return Latin1String();
 	}
 
 	QByteArray hexData = data.toHex();
-	QString result;
 
-	switch (format) {
-		case 1:
-			for (int i = 0; i < hexData.count(); i++) {
+	switch (hexFormat) {
+		case 1: {
+			QByteArray result;
+			result.reserve(hexData.size() + hexData.size() / 2);
+			for (int i = 0; i < hexData.size(); i++) {
 				if (i > 0 && i % 2 == 0)
-					result.append(" ");
+					result.append(' ');
 				result.append(hexData.at(i));
 			}
-			break;
+			return result;
+		}
 
 		case 2:
 			// TODO - Show in columns
-			result = QString::fromLatin1(hexData);
-			break;
+			return hexData;
 
 		default:
-			result = QString::fromLatin1(hexData);
-			break;
+			return hexData;
 	}
-
-	args.GetReturnValue().Set(Utility::toV8String(args.GetIsolate(), result));
 }
 
-void base64(const FunctionCallbackInfo<Value>& args)
+Latin1String base64(NativeCall& call)
 {
-	QByteArray data = ModuleByteArray::unwrapByteArray(args.GetIsolate(), args.Holder());
-	args.GetReturnValue().Set(Utility::toV8String(args.GetIsolate(), QString::fromLatin1(data.toBase64())));
+	return receiverData(call).toBase64();
 }
 
-void hash(const FunctionCallbackInfo<Value>& args)
+QByteArray hash(NativeCall& call, int algorithm)
 {
-	if (args.Length() < 1) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
-		return;
+	QByteArray input = receiverData(call);
+	if (call.isFailed())
+		return QByteArray();
+
+	if (algorithm < QCryptographicHash::Md4 || algorithm > QCryptographicHash::Sha3_512) {
+		call.fail(Utility::ExceptionInvalidArgumentValue);
+		return QByteArray();
 	}
-	if (!args[0]->IsInt32()) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-		return;
+
+	return QCryptographicHash::hash(input, static_cast<QCryptographicHash::Algorithm>(algorithm));
+}
+
+// Hash of copied data computed on pool thread
+class HashTask : public AsyncTasks::Task
+{
+public:
+	HashTask(const QByteArray& data, int hashAlgorithm) : input(data), algorithm(hashAlgorithm) {}
+
+	virtual bool run(QString*)
+	{
+		output = QCryptographicHash::hash(input, static_cast<QCryptographicHash::Algorithm>(algorithm));
+		return true;
 	}
 
-	QByteArray input = ModuleByteArray::unwrapByteArray(args.GetIsolate(), args.Holder());
-	int algorithm = args[0]->Int32Value();
-
-	HandleScope handle_scope(args.GetIsolate());
-
-	QByteArray hashValue;
-	switch (algorithm) {
-		case QCryptographicHash::Md4:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Md4);
-			break;
-		case QCryptographicHash::Md5:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Md5);
-			break;
-		case QCryptographicHash::Sha1:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha1);
-			break;
-		case QCryptographicHash::Sha224:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha224);
-			break;
-		case QCryptographicHash::Sha256:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha256);
-			break;
-		case QCryptographicHash::Sha384:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha384);
-			break;
-		case QCryptographicHash::Sha512:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha512);
-			break;
-		case QCryptographicHash::Sha3_224:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha3_224);
-			break;
-		case QCryptographicHash::Sha3_256:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha3_256);
-			break;
-		case QCryptographicHash::Sha3_384:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha3_384);
-			break;
-		case QCryptographicHash::Sha3_512:
-			hashValue = QCryptographicHash::hash(input, QCryptographicHash::Sha3_512);
-			break;
-
-		default: {
-			Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentValue);
-			return;
-		}
+	virtual Local<Value> result(Isolate* isolate)
+	{
+		return ModuleByteArray::wrapByteArray(isolate, output);
 	}
 
-	args.GetReturnValue().Set(ModuleByteArray::wrapByteArray(args.GetIsolate(), hashValue));
-}
+private:
+	QByteArray input;
+	QByteArray output;
+	int algorithm;
+};
 
-void printable(const FunctionCallbackInfo<Value>& args)
+Local<Promise> hashAsync(NativeCall& call, int algorithm)
 {
-	QByteArray data = ModuleByteArray::unwrapByteArray(args.GetIsolate(), args.Holder());
+	QByteArray input = receiverData(call);
+	if (call.isFailed())
+		return Local<Promise>();
 
-	QString placeholder = ".";
-	if (args.Length() >= 1) {
-		if (!args[0]->IsString()) {
-			Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-			return;
-		}
-		placeholder = Utility::toString(args[0]);
+	if (algorithm < QCryptographicHash::Md4 || algorithm > QCryptographicHash::Sha3_512) {
+		call.fail(Utility::ExceptionInvalidArgumentValue);
+		return Local<Promise>();
 	}
 
+	// Buffer may be changed or collected while task runs, task gets its own copy
+	QByteArray data(input.constData(), input.size());
+	return AsyncTasks::current(call.isolate())->start(call.isolate(), new HashTask(data, algorithm));
+}
+
+QString printable(NativeCall& call, Optional<QString> placeholder)
+{
+	QByteArray data = receiverData(call);
+	QString replacement = placeholder.valueOr(".");
+
 	QString result;
 	result.reserve(data.length());
 
@@ -183,16 +168,15 @@ void printable(const FunctionCallbackInfo<Value>& args)
 		if (QChar::isPrint(c))
 			result.append(c);
 		else
-			result.append(placeholder);
+			result.append(replacement);
 	}
 
-	args.GetReturnValue().Set(Utility::toV8String(args.GetIsolate(), result));
+	return result;
 }
 
-void toString(const FunctionCallbackInfo<Value>& args)
+QString toString(NativeCall& call)
 {
-	QByteArray data = ModuleByteArray::unwrapByteArray(args.GetIsolate(), args.Holder());
-	args.GetReturnValue().Set(Utility::toV8String(args.GetIsolate(), QString::fromUtf8(data)));
+	return QString::fromUtf8(receiverData(call));
 }
 
 void ModuleByteArray::registerTemplates(v8::Isolate* isolate, Local<ObjectTemplate> globalObject)
@@ -201,44 +185,77 @@ void ModuleByteArray::registerTemplates(v8::Isolate* isolate, Local<ObjectTempla
 	Local<ObjectTemplate> object = ObjectTemplate::New(isolate);
 
 	// Create function template for our constructor it will call the constructByteArray function
-	Local<FunctionTemplate> constructorTemplate = FunctionTemplate::New(isolate, constructByteArray);
+	Local<FunctionTemplate> constructorTemplate = NativeBinding::function<decltype(&constructByteArray), &constructByteArray>(isolate, "ByteArray");
 	constructorTemplate->SetClassName(String::NewFromUtf8(isolate, "ByteArray"));
 
 	// Define function added to each instance
 	Local<ObjectTemplate> constructorInstanceTemplate = constructorTemplate->InstanceTemplate();
 	constructorInstanceTemplate->SetInternalFieldCount(1);
-	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "hex"), FunctionTemplate::New(isolate, hex));
-	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "base64"), FunctionTemplate::New(isolate, base64));
-	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "hash"), FunctionTemplate::New(isolate, hash));
-	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "printable"), FunctionTemplate::New(isolate, printable));
-	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "toString"), FunctionTemplate::New(isolate, toString));
-
-	// Store template
-	ByteArrayTemplate.Reset(isolate, constructorInstanceTemplate);
+	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "hex"), NativeBinding::method<decltype(&hex), &hex>(isolate, "ByteArray.hex", constructorTemplate));
+	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "base64"), NativeBinding::method<decltype(&base64), &base64>(isolate, "ByteArray.base64", constructorTemplate));
+	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "hash"), NativeBinding::method<decltype(&hash), &hash>(isolate, "ByteArray.hash", constructorTemplate));
+	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "hashAsync"), NativeBinding::method<decltype(&hashAsync), &hashAsync>(isolate, "ByteArray.hashAsync", constructorTemplate));
+	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "printable"), NativeBinding::method<decltype(&printable), &printable>(isolate, "ByteArray.printable", constructorTemplate));
+	constructorInstanceTemplate->Set(String::NewFromUtf8(isolate, "toString"), NativeBinding::method<decltype(&toString), &toString>(isolate, "ByteArray.toString", constructorTemplate));
+
+	// Store template, each isolate keeps its own
+	Global<ObjectTemplate>* byteArrayTemplate = static_cast<Global<ObjectTemplate>*>(isolate->GetData(Utility::DataSlotByteArrayTemplate));
+	if (byteArrayTemplate == NULL) {
+		byteArrayTemplate = new Global<ObjectTemplate>();
+		isolate->SetData(Utility::DataSlotByteArrayTemplate, byteArrayTemplate);
+	}
+	byteArrayTemplate->Reset(isolate, constructorInstanceTemplate);
 
 	// Set the function in the global scope -- that is, set "ByteArray" to the constructor
 	globalObject->Set(String::NewFromUtf8(isolate, "ByteArray"), constructorTemplate);
 }
 
+void ModuleByteArray::disposeTemplates(Isolate* isolate)
+{
+	delete static_cast<Global<ObjectTemplate>*>(isolate->GetData(Utility::DataSlotByteArrayTemplate));
+	isolate->SetData(Utility::DataSlotByteArrayTemplate, NULL);
+}
+
 Local<Object> ModuleByteArray::wrapByteArray(Isolate* isolate, const QByteArray& data)
+{
+	return wrapArrayBuffer(isolate, Utility::toV8ArrayBuffer(isolate, data));
+}
+
+Local<Object> ModuleByteArray::wrapArrayBuffer(Isolate* isolate, Local<ArrayBuffer> buffer)
 {
 	EscapableHandleScope handle_scope(isolate);
 
 	// Fetch the template for creating ByteArray wrappers.
-	Local<ObjectTemplate> localTemplate = Local<ObjectTemplate>::New(isolate, ByteArrayTemplate);
+	Global<ObjectTemplate>* byteArrayTemplate = static_cast<Global<ObjectTemplate>*>(isolate->GetData(Utility::DataSlotByteArrayTemplate));
+	Local<ObjectTemplate> localTemplate = Local<ObjectTemplate>::New(isolate, *byteArrayTemplate);
 
 	// Create an empty ByteArray wrapper.
 	Local<Object> wrapper = localTemplate->NewInstance(isolate->GetCurrentContext()).ToLocalChecked();
 
 	// Store data in ArrayBuffer
-	wrapper->Set(String::NewFromUtf8(isolate, "buffer"), Utility::toV8ArrayBuffer(isolate, data));
+	wrapper->Set(NativeBinding::name(isolate, NativeBinding::NameBuffer), buffer);
 
 	return handle_scope.Escape(wrapper);
 }
 
+bool ModuleByteArray::isByteArray(Isolate* isolate, Local<Value> value)
+{
+	if (!value->IsObject())
+		return false;
+
+	Local<Object> obj = Local<Object>::Cast(value);
+	if (obj->InternalFieldCount() != 1)
+		return false;
+
+	Local<Value> buffer;
+	if (!obj->Get(isolate->GetCurrentContext(), NativeBinding::name(isolate, NativeBinding::NameBuffer)).ToLocal(&buffer))
+		return false;
+	return buffer->IsArrayBuffer();
+}
+
 QByteArray ModuleByteArray::unwrapByteArray(v8::Isolate* isolate, Local<Object> obj)
 {
-	Local<Value> buffer = obj->Get(String::NewFromUtf8(isolate, "buffer"));
+	Local<Value> buffer = obj->Get(NativeBinding::name(isolate, NativeBinding::NameBuffer));
 	if (!buffer->IsArrayBuffer()) {
 		Utility::throwException(isolate, "ByteArray.buffer must be ArrayBuffer");
 		return QByteArray();
@@ -246,4 +263,4 @@ QByteArray ModuleByteArray::unwrapByteArray(v8::Isolate* isolate, Local<Object>
 
 	v8::ArrayBuffer::Contents c = Local<ArrayBuffer>::Cast(buffer)->GetContents();
 	return QByteArray(reinterpret_cast<const char*>(c.Data()), c.ByteLength());
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -14,9 +14,18 @@ class ModuleByteArray
 public:
 	static void registerTemplates(v8::Isolate* isolate, v8::Local<v8::ObjectTemplate> globalObject);
 
+	// Release template stored in isolate, must be called before isolate is disposed
+	static void disposeTemplates(v8::Isolate* isolate);
+
 	static v8::Local<v8::Object> wrapByteArray(v8::Isolate* isolate, const QByteArray& data);
+
+	// ByteArray using provided buffer without copying it
+	static v8::Local<v8::Object> wrapArrayBuffer(v8::Isolate* isolate, v8::Local<v8::ArrayBuffer> buffer);
 	static QByteArray unwrapByteArray(v8::Isolate* isolate, v8::Local<v8::Object> obj);
 
+	// True for objects created by wrapByteArray or ByteArray constructor
+	static bool isByteArray(v8::Isolate* isolate, v8::Local<v8::Value> value);
+
 private:
 	ModuleByteArray() {}
 };
@@ -0,0 +1,127 @@
+#include "ModuleCache.h"
+#include "WorkbenchEngine.h"
+#include "ValueCache.h"
+#include "ModuleByteArray.h"
+#include "NativeBinding.h"
+#include "Utility.h"
+
+using namespace v8;
+
+
+static ValueCache* engineCache(NativeCall& call)
+{
+	// Values outlive runs, result of run using them is not cached
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(call.data())->Value());
+	workbenchEngine->preventResultCaching();
+	return workbenchEngine->valueCache();
+}
+
+// Objects and arrays are kept as JSON text, they are rebuilt in the context reading them
+static bool stringifyValue(Isolate* isolate, Local<Value> value, QString* json)
+{
+	Local<Context> context = isolate->GetCurrentContext();
+	Local<Value> jsonObject;
+	Local<Value> stringify;
+	if (!context->Global()->Get(context, String::NewFromUtf8(isolate, "JSON")).ToLocal(&jsonObject) || !jsonObject->IsObject())
+		return false;
+	if (!Local<Object>::Cast(jsonObject)->Get(context, String::NewFromUtf8(isolate, "stringify")).ToLocal(&stringify) || !stringify->IsFunction())
+		return false;
+
+	Local<Value> result;
+	if (!Local<Function>::Cast(stringify)->Call(context, jsonObject, 1, &value).ToLocal(&result) || !result->IsString())
+		return false;
+
+	*json = Utility::toString(result);
+	return true;
+}
+
+bool cachePut(NativeCall& call, const QString& key, Local<Value> value)
+{
+	ValueCache::Value cacheValue;
+	QByteArray bytes;
+	if (NativeArgument<QByteArray>::convert(call.isolate(), value, &bytes)) {
+		// Argument only points into javascript buffer
+		cacheValue.type = ValueCache::TypeBytes;
+		cacheValue.bytes = QByteArray(bytes.constData(), bytes.size());
+	}
+	else if (value->IsString()) {
+		cacheValue.type = ValueCache::TypeString;
+		cacheValue.text = Utility::toString(value);
+	}
+	else {
+		TryCatch trycatch(call.isolate());
+		cacheValue.type = ValueCache::TypeJson;
+		if (!stringifyValue(call.isolate(), value, &cacheValue.text)) {
+			if (trycatch.HasCaught())
+				trycatch.ReThrow();
+			else
+				call.fail(Utility::ExceptionInvalidArgumentValue);
+			return false;
+		}
+	}
+
+	return engineCache(call)->put(key, cacheValue);
+}
+
+Local<Value> cacheGet(NativeCall& call, const QString& key, Optional<Local<Value> > defaultValue)
+{
+	Isolate* isolate = call.isolate();
+	ValueCache::Value cacheValue;
+	if (!engineCache(call)->get(key, &cacheValue))
+		return defaultValue.valueOr(Undefined(isolate));
+
+	if (cacheValue.type == ValueCache::TypeBytes)
+		return ModuleByteArray::wrapByteArray(isolate, cacheValue.bytes);
+
+	Local<String> text = Utility::toV8String(isolate, cacheValue.text);
+	if (cacheValue.type == ValueCache::TypeString)
+		return text;
+
+	Local<Value> result;
+	if (!JSON::Parse(isolate, text).ToLocal(&result)) {
+		call.fail("Cached value is not valid JSON");
+		return Undefined(isolate);
+	}
+	return result;
+}
+
+bool cacheHas(NativeCall& call, const QString& key)
+{
+	return engineCache(call)->contains(key);
+}
+
+void cacheRemove(NativeCall& call, const QString& key)
+{
+	engineCache(call)->remove(key);
+}
+
+Local<Value> cacheStats(NativeCall& call)
+{
+	Isolate* isolate = call.isolate();
+	Local<Context> context = isolate->GetCurrentContext();
+	ValueCache::Statistics statistics = engineCache(call)->statistics();
+
+	Local<Object> result = Object::New(isolate);
+	result->Set(context, String::NewFromUtf8(isolate, "count"), Integer::New(isolate, statistics.count)).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "memorySize"), Number::New(isolate, double(statistics.memorySize))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "memoryLimit"), Number::New(isolate, double(statistics.memoryLimit))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "hits"), Number::New(isolate, double(statistics.hitCount))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "diskHits"), Number::New(isolate, double(statistics.diskHitCount))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "misses"), Number::New(isolate, double(statistics.missCount))).FromJust();
+	return result;
+}
+
+void ModuleCache::registerTemplates(Isolate* isolate, Local<ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine)
+{
+	HandleScope handle_scope(isolate);
+	Local<ObjectTemplate> object = ObjectTemplate::New(isolate);
+	Local<External> engineData = External::New(isolate, workbenchEngine);
+
+	object->Set(String::NewFromUtf8(isolate, "put"), NativeBinding::function<decltype(&cachePut), &cachePut>(isolate, "Cache.put", engineData));
+	object->Set(String::NewFromUtf8(isolate, "get"), NativeBinding::function<decltype(&cacheGet), &cacheGet>(isolate, "Cache.get", engineData));
+	object->Set(String::NewFromUtf8(isolate, "has"), NativeBinding::function<decltype(&cacheHas), &cacheHas>(isolate, "Cache.has", engineData));
+	object->Set(String::NewFromUtf8(isolate, "remove"), NativeBinding::function<decltype(&cacheRemove), &cacheRemove>(isolate, "Cache.remove", engineData));
+	object->Set(String::NewFromUtf8(isolate, "stats"), NativeBinding::function<decltype(&cacheStats), &cacheStats>(isolate, "Cache.stats", engineData));
+
+	globalObject->Set(String::NewFromUtf8(isolate, "Cache"), object);
+}
@@ -0,0 +1,22 @@
+#ifndef MODULECACHE_H
+#define MODULECACHE_H
+
+#include "include/v8.h"
+
+class WorkbenchEngine;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Definitions for functions contained in javascript Cache object.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ModuleCache
+{
+public:
+	static void registerTemplates(v8::Isolate* isolate, v8::Local<v8::ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine);
+
+private:
+	ModuleCache() {}
+};
+
+#endif // MODULECACHE_H
@@ -0,0 +1,83 @@
+#include "ModuleOutput.h"
+#include "WorkbenchEngine.h"
+#include "NativeBinding.h"
+#include "Utility.h"
+
+using namespace v8;
+
+
+// Concatenate all arguments and pass them to engine output buffer
+static void appendOutput(const FunctionCallbackInfo<Value>& args, bool isLine)
+{
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	HandleScope handle_scope(args.GetIsolate());
+
+	QString text;
+	for (int i = 0; i < args.Length(); i++)
+		text.append(Utility::toString(args[i]));
+	if (isLine)
+		text.append('\n');
+	NativeStatistics::addBytes(args.GetIsolate(), text.size() * sizeof(QChar), 0);
+
+	if (!workbenchEngine->writeOutput(text))
+		Utility::throwException(args.GetIsolate(), "Could not write output");
+}
+
+void outputWrite(const FunctionCallbackInfo<Value>& args)
+{
+	appendOutput(args, false);
+}
+
+void outputWriteLine(const FunctionCallbackInfo<Value>& args)
+{
+	appendOutput(args, true);
+}
+
+void outputFlush(const FunctionCallbackInfo<Value>& args)
+{
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+
+	if (!workbenchEngine->flushOutput())
+		Utility::throwException(args.GetIsolate(), "Could not write output");
+}
+
+void outputToFile(const FunctionCallbackInfo<Value>& args)
+{
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+
+	// Without file name output goes back to workspace
+	if (args.Length() < 1 || args[0]->IsUndefined()) {
+		if (!workbenchEngine->redirectOutput(QString()))
+			Utility::throwException(args.GetIsolate(), "Could not write output");
+		return;
+	}
+	if (!args[0]->IsString()) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
+		return;
+	}
+
+	QString fileName = Utility::toString(args[0]);
+	NativeStatistics::addBytes(args.GetIsolate(), fileName.size() * sizeof(QChar), 0);
+
+	QString filePath = workbenchEngine->resolveOutputFilePath(fileName);
+	if (filePath.isEmpty()) {
+		Utility::throwException(args.GetIsolate(), QString("Invalid file name: %1").arg(Utility::toString(args[0])));
+		return;
+	}
+	if (!workbenchEngine->redirectOutput(filePath))
+		Utility::throwException(args.GetIsolate(), QString("Could not open file: %1").arg(filePath));
+}
+
+void ModuleOutput::registerTemplates(Isolate* isolate, Local<ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine)
+{
+	HandleScope handle_scope(isolate);
+	Local<ObjectTemplate> object = ObjectTemplate::New(isolate);
+	Local<External> engineData = External::New(isolate, workbenchEngine);
+
+	object->Set(String::NewFromUtf8(isolate, "write"), NativeBinding::callback<outputWrite>(isolate, "Output.write", engineData));
+	object->Set(String::NewFromUtf8(isolate, "writeLine"), NativeBinding::callback<outputWriteLine>(isolate, "Output.writeLine", engineData));
+	object->Set(String::NewFromUtf8(isolate, "flush"), NativeBinding::callback<outputFlush>(isolate, "Output.flush", engineData));
+	object->Set(String::NewFromUtf8(isolate, "toFile"), NativeBinding::callback<outputToFile>(isolate, "Output.toFile", engineData));
+
+	globalObject->Set(String::NewFromUtf8(isolate, "Output"), object);
+}
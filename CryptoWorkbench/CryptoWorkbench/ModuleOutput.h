@@ -0,0 +1,22 @@
+#ifndef MODULEOUTPUT_H
+#define MODULEOUTPUT_H
+
+#include "include/v8.h"
+
+class WorkbenchEngine;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Definitions for functions contained in javascript Output object.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ModuleOutput
+{
+public:
+	static void registerTemplates(v8::Isolate* isolate, v8::Local<v8::ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine);
+
+private:
+	ModuleOutput() {}
+};
+
+#endif // MODULEOUTPUT_H
@@ -0,0 +1,96 @@
+#include "ModuleParallel.h"
+#include "WorkbenchEngine.h"
+#include "WorkerPool.h"
+#include "ModuleByteArray.h"
+#include "NativeBinding.h"
+#include "Utility.h"
+
+using namespace v8;
+
+
+void workerCount(const FunctionCallbackInfo<Value>& args)
+{
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	WorkerPool* workerPool = workbenchEngine->workerPool();
+
+	args.GetReturnValue().Set(workerPool != NULL ? workerPool->count() : 0);
+}
+
+void runParallel(const FunctionCallbackInfo<Value>& args)
+{
+	if (args.Length() < 2) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
+		return;
+	}
+	if (!args[0]->IsString() || !args[1]->IsArray()) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
+		return;
+	}
+
+	Isolate* isolate = args.GetIsolate();
+	HandleScope handle_scope(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	WorkerPool* workerPool = workbenchEngine->workerPool();
+
+	// Files read by workers are not tracked by this engine
+	workbenchEngine->preventResultCaching();
+	if (workerPool == NULL) {
+		Utility::throwException(isolate, "Parallel execution is not available");
+		return;
+	}
+
+	QString scriptText = Utility::toString(args[0]);
+	Local<Array> inputArray = Local<Array>::Cast(args[1]);
+
+	QStringList inputs;
+	size_t bytesIn = scriptText.size() * sizeof(QChar);
+	for (uint32_t i = 0; i < inputArray->Length(); i++) {
+		Local<Value> input;
+		if (!inputArray->Get(context, i).ToLocal(&input))
+			return;
+		inputs.append(Utility::toString(input));
+		bytesIn += inputs.last().size() * sizeof(QChar);
+	}
+
+	QList<ScriptResult> results = workerPool->evaluate(scriptText, inputs);
+
+	Local<Array> outputArray = Array::New(isolate, results.count());
+	size_t bytesOut = 0;
+	for (int i = 0; i < results.count(); i++) {
+		if (!results.at(i).isValid()) {
+			Utility::throwException(isolate, QString("Worker %1 failed: %2").arg(i).arg(results.at(i).data()));
+			return;
+		}
+
+		// Binary results come back as ByteArray, everything else as text
+		const ScriptResult& result = results.at(i);
+		Local<Value> output;
+		if (result.type() == ScriptResult::TypeBytes) {
+			output = ModuleByteArray::wrapByteArray(isolate, result.bytes());
+			bytesOut += result.bytes().size();
+		}
+		else {
+			QString text = result.data();
+			output = Utility::toV8String(isolate, text);
+			bytesOut += text.size() * sizeof(QChar);
+		}
+		outputArray->Set(context, i, output).FromJust();
+	}
+
+	NativeStatistics::addBytes(isolate, bytesIn, bytesOut);
+	args.GetReturnValue().Set(outputArray);
+}
+
+void ModuleParallel::registerTemplates(Isolate* isolate, Local<ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine)
+{
+	HandleScope handle_scope(isolate);
+	Local<ObjectTemplate> object = ObjectTemplate::New(isolate);
+	Local<External> engineData = External::New(isolate, workbenchEngine);
+
+	object->Set(String::NewFromUtf8(isolate, "workers"), FunctionTemplate::New(isolate, workerCount, engineData));
+	object->Set(String::NewFromUtf8(isolate, "run"), NativeBinding::callback<runParallel>(isolate, "Parallel.run", engineData));
+
+	globalObject->Set(String::NewFromUtf8(isolate, "Parallel"), object);
+}
@@ -0,0 +1,22 @@
+#ifndef MODULEPARALLEL_H
+#define MODULEPARALLEL_H
+
+#include "include/v8.h"
+
+class WorkbenchEngine;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Definitions for functions contained in javascript Parallel object.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ModuleParallel
+{
+public:
+	static void registerTemplates(v8::Isolate* isolate, v8::Local<v8::ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine);
+
+private:
+	ModuleParallel() {}
+};
+
+#endif // MODULEPARALLEL_H
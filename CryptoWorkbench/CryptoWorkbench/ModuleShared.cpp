@@ -0,0 +1,104 @@
+#include "ModuleShared.h"
+#include "WorkbenchEngine.h"
+#include "SharedData.h"
+#include "ModuleByteArray.h"
+#include "NativeBinding.h"
+#include "Utility.h"
+
+using namespace v8;
+
+
+// Published data lives outside the run, result of run using it is not cached
+static void preventCaching(NativeCall& call)
+{
+	reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(call.data())->Value())->preventResultCaching();
+}
+
+void sharedPublish(NativeCall& call, const QString& name, Local<Value> value)
+{
+	preventCaching(call);
+	QByteArray bytes;
+	if (NativeArgument<QByteArray>::convert(call.isolate(), value, &bytes)) {
+		// Argument only points into javascript buffer
+		SharedData::publish(name, QByteArray(bytes.constData(), bytes.size()));
+	}
+	else if (value->IsString()) {
+		SharedData::publish(name, Utility::toString(value).toUtf8());
+	}
+	else {
+		call.fail(Utility::ExceptionInvalidArgumentType);
+	}
+}
+
+void sharedPublishFile(NativeCall& call, const QString& name, const QString& fileName)
+{
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(call.data())->Value());
+	workbenchEngine->preventResultCaching();
+	QString filePath = workbenchEngine->resolveScriptFilePath(fileName);
+	if (filePath.isEmpty()) {
+		call.fail("Invalid file parameter");
+		return;
+	}
+
+	QString errorMessage;
+	if (!SharedData::publishFile(name, filePath, &errorMessage))
+		call.fail(errorMessage);
+}
+
+Local<Value> sharedGet(NativeCall& call, const QString& name)
+{
+	preventCaching(call);
+	Local<ArrayBuffer> buffer = SharedData::arrayBuffer(call.isolate(), name);
+	if (buffer.IsEmpty())
+		return Undefined(call.isolate());
+	return ModuleByteArray::wrapArrayBuffer(call.isolate(), buffer);
+}
+
+Local<Value> sharedText(NativeCall& call, const QString& name)
+{
+	preventCaching(call);
+	Local<String> text = SharedData::text(call.isolate(), name);
+	if (text.IsEmpty())
+		return Undefined(call.isolate());
+	return text;
+}
+
+bool sharedRemove(NativeCall& call, const QString& name)
+{
+	preventCaching(call);
+	return SharedData::remove(name);
+}
+
+Local<Value> sharedList(NativeCall& call)
+{
+	preventCaching(call);
+	Isolate* isolate = call.isolate();
+	Local<Context> context = isolate->GetCurrentContext();
+	QList<SharedData::Item> items = SharedData::items();
+
+	Local<Array> result = Array::New(isolate, items.count());
+	for (int i = 0; i < items.count(); i++) {
+		Local<Object> item = Object::New(isolate);
+		item->Set(context, String::NewFromUtf8(isolate, "name"), Utility::toV8String(isolate, items.at(i).name)).FromJust();
+		item->Set(context, String::NewFromUtf8(isolate, "size"), Number::New(isolate, double(items.at(i).size))).FromJust();
+		item->Set(context, String::NewFromUtf8(isolate, "views"), Integer::New(isolate, items.at(i).viewCount)).FromJust();
+		result->Set(context, i, item).FromJust();
+	}
+	return result;
+}
+
+void ModuleShared::registerTemplates(Isolate* isolate, Local<ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine)
+{
+	HandleScope handle_scope(isolate);
+	Local<ObjectTemplate> object = ObjectTemplate::New(isolate);
+	Local<External> engineData = External::New(isolate, workbenchEngine);
+
+	object->Set(String::NewFromUtf8(isolate, "publish"), NativeBinding::function<decltype(&sharedPublish), &sharedPublish>(isolate, "Shared.publish", engineData));
+	object->Set(String::NewFromUtf8(isolate, "publishFile"), NativeBinding::function<decltype(&sharedPublishFile), &sharedPublishFile>(isolate, "Shared.publishFile", engineData));
+	object->Set(String::NewFromUtf8(isolate, "get"), NativeBinding::function<decltype(&sharedGet), &sharedGet>(isolate, "Shared.get", engineData));
+	object->Set(String::NewFromUtf8(isolate, "text"), NativeBinding::function<decltype(&sharedText), &sharedText>(isolate, "Shared.text", engineData));
+	object->Set(String::NewFromUtf8(isolate, "remove"), NativeBinding::function<decltype(&sharedRemove), &sharedRemove>(isolate, "Shared.remove", engineData));
+	object->Set(String::NewFromUtf8(isolate, "list"), NativeBinding::function<decltype(&sharedList), &sharedList>(isolate, "Shared.list", engineData));
+
+	globalObject->Set(String::NewFromUtf8(isolate, "Shared"), object);
+}
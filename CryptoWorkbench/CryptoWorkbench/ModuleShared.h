@@ -0,0 +1,22 @@
+#ifndef MODULESHARED_H
+#define MODULESHARED_H
+
+#include "include/v8.h"
+
+class WorkbenchEngine;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Definitions for functions contained in javascript Shared object.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ModuleShared
+{
+public:
+	static void registerTemplates(v8::Isolate* isolate, v8::Local<v8::ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine);
+
+private:
+	ModuleShared() {}
+};
+
+#endif // MODULESHARED_H
@@ -0,0 +1,151 @@
+#include "ModuleStats.h"
+#include "WorkbenchEngine.h"
+#include "NativeStatistics.h"
+#include "Utility.h"
+
+using namespace v8;
+
+
+void allocatorStatistics(const FunctionCallbackInfo<Value>& args)
+{
+	Isolate* isolate = args.GetIsolate();
+	HandleScope handle_scope(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+
+	// Measurements differ between runs, results depending on them are not cached
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	workbenchEngine->preventResultCaching();
+	BufferAllocator::Statistics stats = workbenchEngine->allocatorStatistics();
+
+	Local<Object> result = Object::New(isolate);
+	result->Set(context, String::NewFromUtf8(isolate, "liveBytes"), Number::New(isolate, double(stats.liveBytes))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "peakBytes"), Number::New(isolate, double(stats.peakBytes))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "pooledBytes"), Number::New(isolate, double(stats.pooledBytes))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "allocations"), Number::New(isolate, double(stats.allocationCount))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "poolHits"), Number::New(isolate, double(stats.poolHitCount))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "hitRate"), Number::New(isolate, stats.hitRate())).FromJust();
+
+	args.GetReturnValue().Set(result);
+}
+
+void heapStatistics(const FunctionCallbackInfo<Value>& args)
+{
+	Isolate* isolate = args.GetIsolate();
+	HandleScope handle_scope(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	workbenchEngine->preventResultCaching();
+	HeapUsage usage = workbenchEngine->heapUsage();
+
+	Local<Array> spaces = Array::New(isolate, usage.spaces.count());
+	for (int i = 0; i < usage.spaces.count(); i++) {
+		const HeapUsage::Space& space = usage.spaces.at(i);
+		Local<Object> spaceObject = Object::New(isolate);
+		spaceObject->Set(context, String::NewFromUtf8(isolate, "name"), Utility::toV8String(isolate, space.name)).FromJust();
+		spaceObject->Set(context, String::NewFromUtf8(isolate, "size"), Number::New(isolate, double(space.size))).FromJust();
+		spaceObject->Set(context, String::NewFromUtf8(isolate, "usedSize"), Number::New(isolate, double(space.usedSize))).FromJust();
+		spaceObject->Set(context, String::NewFromUtf8(isolate, "availableSize"), Number::New(isolate, double(space.availableSize))).FromJust();
+		spaces->Set(context, i, spaceObject).FromJust();
+	}
+
+	Local<Object> result = Object::New(isolate);
+	result->Set(context, String::NewFromUtf8(isolate, "totalHeapSize"), Number::New(isolate, double(usage.totalHeapSize))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "usedHeapSize"), Number::New(isolate, double(usage.usedHeapSize))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "heapSizeLimit"), Number::New(isolate, double(usage.heapSizeLimit))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "externalSize"), Number::New(isolate, double(usage.externalSize))).FromJust();
+	result->Set(context, String::NewFromUtf8(isolate, "spaces"), spaces).FromJust();
+
+	args.GetReturnValue().Set(result);
+}
+
+void heapSnapshot(const FunctionCallbackInfo<Value>& args)
+{
+	if (args.Length() < 1) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
+		return;
+	}
+	if (!args[0]->IsString()) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
+		return;
+	}
+
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	workbenchEngine->preventResultCaching();
+	QString filePath = workbenchEngine->resolveOutputFilePath(Utility::toString(args[0]));
+	if (filePath.isEmpty()) {
+		Utility::throwException(args.GetIsolate(), QString("Invalid file name: %1").arg(Utility::toString(args[0])));
+		return;
+	}
+
+	if (!workbenchEngine->writeHeapSnapshot(filePath)) {
+		Utility::throwException(args.GetIsolate(), QString("Could not write heap snapshot: %1").arg(filePath));
+		return;
+	}
+}
+
+void nativeStatistics(const FunctionCallbackInfo<Value>& args)
+{
+	Isolate* isolate = args.GetIsolate();
+	HandleScope handle_scope(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+
+	// Empty list when collection is disabled
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	workbenchEngine->preventResultCaching();
+	QList<NativeStatistics::Counter> counters;
+	if (workbenchEngine->nativeStatistics() != NULL)
+		counters = workbenchEngine->nativeStatistics()->counters();
+
+	Local<Array> result = Array::New(isolate, counters.count());
+	for (int i = 0; i < counters.count(); i++) {
+		const NativeStatistics::Counter& counter = counters.at(i);
+
+		Local<Array> histogram = Array::New(isolate, counter.histogram.count());
+		for (int j = 0; j < counter.histogram.count(); j++)
+			histogram->Set(context, j, Number::New(isolate, double(counter.histogram.at(j)))).FromJust();
+
+		Local<Object> nativeObject = Object::New(isolate);
+		nativeObject->Set(context, String::NewFromUtf8(isolate, "name"), Utility::toV8String(isolate, counter.name)).FromJust();
+		nativeObject->Set(context, String::NewFromUtf8(isolate, "calls"), Number::New(isolate, double(counter.callCount))).FromJust();
+		nativeObject->Set(context, String::NewFromUtf8(isolate, "bytesIn"), Number::New(isolate, double(counter.bytesIn))).FromJust();
+		nativeObject->Set(context, String::NewFromUtf8(isolate, "bytesOut"), Number::New(isolate, double(counter.bytesOut))).FromJust();
+		nativeObject->Set(context, String::NewFromUtf8(isolate, "totalMs"), Number::New(isolate, counter.totalTime / 1e6)).FromJust();
+		nativeObject->Set(context, String::NewFromUtf8(isolate, "conversionMs"), Number::New(isolate, (counter.totalTime - counter.workTime) / 1e6)).FromJust();
+		nativeObject->Set(context, String::NewFromUtf8(isolate, "histogram"), histogram).FromJust();
+		result->Set(context, i, nativeObject).FromJust();
+	}
+
+	args.GetReturnValue().Set(result);
+}
+
+void collectNativeStatistics(const FunctionCallbackInfo<Value>& args)
+{
+	if (args.Length() < 1) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
+		return;
+	}
+	if (!args[0]->IsBoolean()) {
+		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
+		return;
+	}
+
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	workbenchEngine->preventResultCaching();
+	workbenchEngine->setNativeStatisticsEnabled(args[0]->BooleanValue(args.GetIsolate()->GetCurrentContext()).FromJust());
+}
+
+void ModuleStats::registerTemplates(Isolate* isolate, Local<ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine)
+{
+	HandleScope handle_scope(isolate);
+	Local<ObjectTemplate> object = ObjectTemplate::New(isolate);
+	Local<External> engineData = External::New(isolate, workbenchEngine);
+
+	object->Set(String::NewFromUtf8(isolate, "allocator"), FunctionTemplate::New(isolate, allocatorStatistics, engineData));
+	object->Set(String::NewFromUtf8(isolate, "heap"), FunctionTemplate::New(isolate, heapStatistics, engineData));
+	object->Set(String::NewFromUtf8(isolate, "heapSnapshot"), FunctionTemplate::New(isolate, heapSnapshot, engineData));
+	object->Set(String::NewFromUtf8(isolate, "natives"), FunctionTemplate::New(isolate, nativeStatistics, engineData));
+	object->Set(String::NewFromUtf8(isolate, "collectNatives"), FunctionTemplate::New(isolate, collectNativeStatistics, engineData));
+
+	globalObject->Set(String::NewFromUtf8(isolate, "Stats"), object);
+}
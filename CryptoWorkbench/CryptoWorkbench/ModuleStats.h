@@ -0,0 +1,22 @@
+#ifndef MODULESTATS_H
+#define MODULESTATS_H
+
+#include "include/v8.h"
+
+class WorkbenchEngine;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Definitions for functions contained in javascript Stats object.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ModuleStats
+{
+public:
+	static void registerTemplates(v8::Isolate* isolate, v8::Local<v8::ObjectTemplate> globalObject, WorkbenchEngine* workbenchEngine);
+
+private:
+	ModuleStats() {}
+};
+
+#endif // MODULESTATS_H
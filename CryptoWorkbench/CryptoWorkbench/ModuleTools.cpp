@@ -1,5 +1,7 @@
 #include "ModuleTools.h"
 #include "Utility.h"
+#include "NativeBinding.h"
+#include "AsyncTasks.h"
 #include <QVector>
 #include <QStringList>
 
@@ -40,37 +42,35 @@ QString replaceLettersImpl(const QString& input, const QString& sourceLetterTabl
 	return result;
 }
 
-void rotateAlphabet(const FunctionCallbackInfo<Value>& args)
+// Most frequent values first, list ends before values with frequency of limit - 1
+Local<Array> frequencyArray(Isolate* isolate, const QVector<FrequencyValue>& values, int frequencyLimit)
 {
-	if (args.Length() < 1) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
-		return;
-	}
-	if (!args[0]->IsString()) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-		return;
-	}
-
-	int shiftValue = 13;
-	if (args.Length() > 1) {
-		if (!args[1]->IsInt32()) {
-			Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-			return;
-		}
+	Local<Context> context = isolate->GetCurrentContext();
+	Local<String> valueName = NativeBinding::name(isolate, NativeBinding::NameValue);
+	Local<String> frequencyName = NativeBinding::name(isolate, NativeBinding::NameFrequency);
 
-		shiftValue = args[1]->Int32Value();
+	Local<Array> resultArray = Array::New(isolate);
+	for (int i = 0; i < values.count(); i++) {
+		const FrequencyValue& item = values.at(i);
+		if (item.frequency == frequencyLimit - 1)
+			break;
 
-		shiftValue = shiftValue % 26;
-		if (shiftValue < 0)
-			shiftValue = 26 + shiftValue;
+		Local<Object> object = Object::New(isolate);
+		object->Set(context, valueName, Utility::toV8String(isolate, item.value)).FromJust();
+		object->Set(context, frequencyName, Int32::New(isolate, item.frequency)).FromJust();
+		resultArray->Set(context, i, object).FromJust();
 	}
+	return resultArray;
+}
 
-	if (shiftValue == 0) {
-		args.GetReturnValue().Set(args[0]);
-		return;
-	}
+QString rotateAlphabet(NativeCall& call, const QString& input, Optional<int> shift)
+{
+	int shiftValue = shift.valueOr(13) % 26;
+	if (shiftValue < 0)
+		shiftValue = 26 + shiftValue;
 
-	QString input = Utility::toString(args[0]);
+	if (shiftValue == 0)
+		return input;
 
 	static QString alphabet = "abcdefghijklmnopqrstuvwxyz";
 	QString rotated = alphabet.mid(shiftValue) + alphabet.mid(0, shiftValue);
@@ -78,63 +78,21 @@ void rotateAlphabet(const FunctionCallbackInfo<Value>& args)
 	static QString sourceTable = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
 	QString outputTable = rotated + rotated.toUpper();
 
-	QString result = replaceLettersImpl(input, sourceTable, outputTable, true);
-	args.GetReturnValue().Set(Utility::toV8String(args.GetIsolate(), result));
+	return replaceLettersImpl(input, sourceTable, outputTable, true);
 }
 
-void replaceLetters(const FunctionCallbackInfo<Value>& args)
+QString replaceLetters(NativeCall& call, const QString& input, const QString& sourceTable, const QString& outputTable)
 {
-	if (args.Length() < 3) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
-		return;
-	}
-	if (!args[0]->IsString() || !args[1]->IsString() || !args[2]->IsString()) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-		return;
-	}
-
-	QString input = Utility::toString(args[0]);
-	QString sourceTable = Utility::toString(args[1]);
-	QString outputTable = Utility::toString(args[2]);
-
 	if (sourceTable.length() != outputTable.length()) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentValue);
-		return;
+		call.fail(Utility::ExceptionInvalidArgumentValue);
+		return QString();
 	}
 
-	QString result = replaceLettersImpl(input, sourceTable, outputTable, true);
-	args.GetReturnValue().Set(Utility::toV8String(args.GetIsolate(), result));
+	return replaceLettersImpl(input, sourceTable, outputTable, true);
 }
 
-void ngramFrequency(const FunctionCallbackInfo<Value>& args)
+QVector<FrequencyValue> countNgrams(const QString& input, int ngramLength)
 {
-	if (args.Length() < 2) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
-		return;
-	}
-	if (!args[0]->IsString() || !args[1]->IsInt32()) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-		return;
-	}
-
-	int frequencyLimit = 0;
-	if (args.Length() > 2) {
-		if (!args[2]->IsInt32()) {
-			Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-			return;
-		}
-
-		frequencyLimit = args[2]->Int32Value();
-	}
-
-	QString input = Utility::toString(args[0]);
-	int ngramLength = args[1]->Int32Value();
-
-	if (ngramLength <= 0) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentValue);
-		return;
-	}
-
 	QVector<FrequencyValue> values;
 
 	// Calculate ngrams
@@ -155,48 +113,55 @@ void ngramFrequency(const FunctionCallbackInfo<Value>& args)
 	}
 
 	qSort(values);
+	return values;
+}
 
-	// Print results
-	Isolate* isolate = args.GetIsolate();
-	HandleScope handle_scope(isolate);
-	Local<Array> resultArray = Array::New(isolate);
-	for (int i = 0; i < values.count(); i++) {
-		const FrequencyValue& ngram = values.at(i);
-		if (ngram.frequency == frequencyLimit - 1)
-			break;
-
-		Local<Object> object = Object::New(isolate);
-		object->Set(Utility::toV8String(isolate, "value"), Utility::toV8String(isolate, ngram.value));
-		object->Set(Utility::toV8String(isolate, "frequency"), Int32::New(isolate, ngram.frequency));
-		resultArray->Set(i, object);
+Local<Array> ngramFrequency(NativeCall& call, const QString& input, int ngramLength, Optional<int> frequencyLimit)
+{
+	if (ngramLength <= 0) {
+		call.fail(Utility::ExceptionInvalidArgumentValue);
+		return Local<Array>();
 	}
 
-	args.GetReturnValue().Set(resultArray);
+	return frequencyArray(call.isolate(), countNgrams(input, ngramLength), frequencyLimit.valueOr(0));
 }
 
-void wordFrequency(const FunctionCallbackInfo<Value>& args)
+// Ngrams counted on pool thread, result array is built when promise is settled
+class NgramFrequencyTask : public AsyncTasks::Task
 {
-	if (args.Length() == 0) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
-		return;
+public:
+	NgramFrequencyTask(const QString& text, int length, int limit) : input(text), ngramLength(length), frequencyLimit(limit) {}
+
+	virtual bool run(QString*)
+	{
+		values = countNgrams(input, ngramLength);
+		return true;
 	}
-	if (!args[0]->IsString()) {
-		Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-		return;
+
+	virtual Local<Value> result(Isolate* isolate)
+	{
+		return frequencyArray(isolate, values, frequencyLimit);
 	}
 
-	int frequencyLimit = 0;
-	if (args.Length() > 1) {
-		if (!args[1]->IsInt32()) {
-			Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
-			return;
-		}
+private:
+	QString input;
+	int ngramLength;
+	int frequencyLimit;
+	QVector<FrequencyValue> values;
+};
 
-		frequencyLimit = args[1]->Int32Value();
+Local<Promise> ngramFrequencyAsync(NativeCall& call, const QString& input, int ngramLength, Optional<int> frequencyLimit)
+{
+	if (ngramLength <= 0) {
+		call.fail(Utility::ExceptionInvalidArgumentValue);
+		return Local<Promise>();
 	}
 
-	QString input = Utility::toString(args[0]);
+	return AsyncTasks::current(call.isolate())->start(call.isolate(), new NgramFrequencyTask(input, ngramLength, frequencyLimit.valueOr(0)));
+}
 
+Local<Array> wordFrequency(NativeCall& call, const QString& input, Optional<int> frequencyLimit)
+{
 	QVector<FrequencyValue> values;
 	QStringList list = input.split(' ', QString::SkipEmptyParts);
 
@@ -214,22 +179,7 @@ void wordFrequency(const FunctionCallbackInfo<Value>& args)
 
 	qSort(values);
 
-	// Print results
-	Isolate* isolate = args.GetIsolate();
-	HandleScope handle_scope(isolate);
-	Local<Array> resultArray = Array::New(isolate);
-	for (int i = 0; i < values.count(); i++) {
-		const FrequencyValue& word = values.at(i);
-		if (word.frequency == frequencyLimit - 1)
-			break;
-
-		Local<Object> object = Object::New(isolate);
-		object->Set(Utility::toV8String(isolate, "value"), Utility::toV8String(isolate, word.value));
-		object->Set(Utility::toV8String(isolate, "frequency"), Int32::New(isolate, word.frequency));
-		resultArray->Set(i, object);
-	}
-
-	args.GetReturnValue().Set(resultArray);
+	return frequencyArray(call.isolate(), values, frequencyLimit.valueOr(0));
 }
 
 void ModuleTools::registerTemplates(v8::Isolate* isolate, Local<ObjectTemplate> globalObject)
@@ -239,10 +189,11 @@ void ModuleTools::registerTemplates(v8::Isolate* isolate, Local<ObjectTemplate>
 
 	//fileObject->Set(String::NewFromUtf8(isolate, "read"), FunctionTemplate::New(isolate, readFileCallback, External::New(isolate, this)));
 
-	object->Set(String::NewFromUtf8(isolate, "rotateAlphabet"), FunctionTemplate::New(isolate, rotateAlphabet));
-	object->Set(String::NewFromUtf8(isolate, "replaceLetters"), FunctionTemplate::New(isolate, replaceLetters));
-	object->Set(String::NewFromUtf8(isolate, "ngramFrequency"), FunctionTemplate::New(isolate, ngramFrequency));
-	object->Set(String::NewFromUtf8(isolate, "wordFrequency"), FunctionTemplate::New(isolate, wordFrequency));
+	object->Set(String::NewFromUtf8(isolate, "rotateAlphabet"), NativeBinding::function<decltype(&rotateAlphabet), &rotateAlphabet>(isolate, "Tools.rotateAlphabet"));
+	object->Set(String::NewFromUtf8(isolate, "replaceLetters"), NativeBinding::function<decltype(&replaceLetters), &replaceLetters>(isolate, "Tools.replaceLetters"));
+	object->Set(String::NewFromUtf8(isolate, "ngramFrequency"), NativeBinding::function<decltype(&ngramFrequency), &ngramFrequency>(isolate, "Tools.ngramFrequency"));
+	object->Set(String::NewFromUtf8(isolate, "ngramFrequencyAsync"), NativeBinding::function<decltype(&ngramFrequencyAsync), &ngramFrequencyAsync>(isolate, "Tools.ngramFrequencyAsync"));
+	object->Set(String::NewFromUtf8(isolate, "wordFrequency"), NativeBinding::function<decltype(&wordFrequency), &wordFrequency>(isolate, "Tools.wordFrequency"));
 
 	globalObject->Set(String::NewFromUtf8(isolate, "Tools"), object);
 }
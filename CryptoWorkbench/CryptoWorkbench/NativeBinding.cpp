@@ -0,0 +1,103 @@
+#include "NativeBinding.h"
+#include "ModuleByteArray.h"
+
+using namespace v8;
+
+
+static const char* propertyNames[NativeBinding::PropertyNameCount] = { "buffer", "value", "frequency", "get", "set", "writable" };
+
+// Eternal handles can't be released, they live as long as the isolate
+struct PropertyNameCache
+{
+	Eternal<String> names[NativeBinding::PropertyNameCount];
+};
+
+bool NativeArgument<QString>::convert(Isolate* isolate, Local<Value> value, QString* result)
+{
+	if (!value->IsString())
+		return false;
+
+	// Copy UTF-16 straight into QString, no UTF-8 round trip
+	Local<String> string = Local<String>::Cast(value);
+	int length = string->Length();
+	result->resize(length);
+	string->Write(reinterpret_cast<uint16_t*>(result->data()), 0, length, String::NO_NULL_TERMINATION);
+	return true;
+}
+
+bool NativeArgument<Latin1String>::convert(Isolate* isolate, Local<Value> value, Latin1String* result)
+{
+	if (!value->IsString())
+		return false;
+
+	Local<String> string = Local<String>::Cast(value);
+	int length = string->Length();
+	if (!string->IsOneByte()) {
+		// Characters above 0xFF would be truncated by WriteOneByte, let Qt replace them
+		QString text;
+		text.resize(length);
+		string->Write(reinterpret_cast<uint16_t*>(text.data()), 0, length, String::NO_NULL_TERMINATION);
+		result->data = text.toLatin1();
+		return true;
+	}
+
+	result->data.resize(length);
+	string->WriteOneByte(reinterpret_cast<uint8_t*>(result->data.data()), 0, length, String::NO_NULL_TERMINATION);
+	return true;
+}
+
+bool NativeArgument<QByteArray>::convert(Isolate* isolate, Local<Value> value, QByteArray* result)
+{
+	// ByteArray keeps its data in buffer property
+	Local<Value> buffer = value;
+	if (value->IsObject() && !value->IsArrayBuffer() && Local<Object>::Cast(value)->InternalFieldCount() == 1) {
+		if (!Local<Object>::Cast(value)->Get(isolate->GetCurrentContext(), NativeBinding::name(isolate, NativeBinding::NameBuffer)).ToLocal(&buffer))
+			return false;
+	}
+	if (!buffer->IsArrayBuffer())
+		return false;
+
+	ArrayBuffer::Contents contents = Local<ArrayBuffer>::Cast(buffer)->GetContents();
+	*result = QByteArray::fromRawData(static_cast<const char*>(contents.Data()), static_cast<int>(contents.ByteLength()));
+	return true;
+}
+
+void NativeReturn<QString>::set(const FunctionCallbackInfo<Value>& args, const QString& value)
+{
+	args.GetReturnValue().Set(Utility::toV8String(args.GetIsolate(), value));
+}
+
+void NativeReturn<Latin1String>::set(const FunctionCallbackInfo<Value>& args, const Latin1String& value)
+{
+	Local<String> string;
+	if (!String::NewFromOneByte(args.GetIsolate(), reinterpret_cast<const uint8_t*>(value.data.constData()), NewStringType::kNormal, value.data.size()).ToLocal(&string)) {
+		Utility::throwException(args.GetIsolate(), "String too long");
+		return;
+	}
+	args.GetReturnValue().Set(string);
+}
+
+void NativeReturn<QByteArray>::set(const FunctionCallbackInfo<Value>& args, const QByteArray& value)
+{
+	args.GetReturnValue().Set(ModuleByteArray::wrapByteArray(args.GetIsolate(), value));
+}
+
+Local<String> NativeBinding::name(Isolate* isolate, PropertyName name)
+{
+	PropertyNameCache* cache = static_cast<PropertyNameCache*>(isolate->GetData(Utility::DataSlotPropertyNames));
+	if (cache == NULL) {
+		cache = new PropertyNameCache();
+		isolate->SetData(Utility::DataSlotPropertyNames, cache);
+	}
+
+	Eternal<String>& handle = cache->names[name];
+	if (handle.IsEmpty())
+		handle.Set(isolate, String::NewFromOneByte(isolate, reinterpret_cast<const uint8_t*>(propertyNames[name]), NewStringType::kInternalized).ToLocalChecked());
+	return handle.Get(isolate);
+}
+
+void NativeBinding::disposeNames(Isolate* isolate)
+{
+	delete static_cast<PropertyNameCache*>(isolate->GetData(Utility::DataSlotPropertyNames));
+	isolate->SetData(Utility::DataSlotPropertyNames, NULL);
+}
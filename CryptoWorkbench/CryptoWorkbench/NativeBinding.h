@@ -0,0 +1,473 @@
+#ifndef NATIVEBINDING_H
+#define NATIVEBINDING_H
+
+#include <QString>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <tuple>
+#include "include/v8.h"
+#include "Utility.h"
+#include "NativeStatistics.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Declarative binding of C++ functions to javascript
+///
+/// Native is a plain function taking NativeCall& followed by its arguments:
+///     QString rotateAlphabet(NativeCall& call, const QString& input, Optional<int> shift);
+/// Wrapper checking argument count and types is generated from the signature:
+///     NativeBinding::function<decltype(&rotateAlphabet), &rotateAlphabet>(isolate, "Tools.rotateAlphabet");
+/// Name identifies the native in NativeStatistics.
+///
+////////////////////////////////////////////////////////////////////////////////////
+
+// State of single native call, natives report errors through it
+class NativeCall
+{
+public:
+	NativeCall(const v8::FunctionCallbackInfo<v8::Value>& callbackInfo) : args(callbackInfo), isCallFailed(false) {}
+
+	v8::Isolate* isolate() const { return args.GetIsolate(); }
+	v8::Local<v8::Object> holder() const { return args.Holder(); }
+	v8::Local<v8::Value> data() const { return args.Data(); }
+	bool isConstructCall() const { return args.IsConstructCall(); }
+
+	// Throw javascript exception, return value of native is ignored
+	void fail(Utility::ExceptionType exception) { Utility::throwException(isolate(), exception); isCallFailed = true; }
+	void fail(const QString& message) { Utility::throwException(isolate(), message); isCallFailed = true; }
+	bool isFailed() const { return isCallFailed; }
+
+private:
+	const v8::FunctionCallbackInfo<v8::Value>& args;
+	bool isCallFailed;
+};
+
+// Trailing argument which may be left out or undefined
+template <typename T>
+struct Optional
+{
+	Optional() : value(), isSet(false) {}
+
+	T valueOr(const T& defaultValue) const { return isSet ? value : defaultValue; }
+
+	T value;
+	bool isSet;
+};
+
+// Trailing argument which is treated as left out when it has the wrong type
+template <typename T>
+struct LenientOptional : Optional<T> {};
+
+// Text with one byte per character, crosses the boundary without UTF-16 conversion
+struct Latin1String
+{
+	Latin1String() {}
+	Latin1String(const QByteArray& text) : data(text) {}
+
+	QByteArray data;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Conversion of javascript arguments, convert() returns false on type mismatch
+///
+////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+struct NativeArgument;
+
+template <typename T>
+struct NativeArgument<const T&> : NativeArgument<T> {};
+
+template <>
+struct NativeArgument<int>
+{
+	typedef int Type;
+	enum { isOptional = false };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, int* result)
+	{
+		if (!value->IsInt32())
+			return false;
+		*result = value->Int32Value(isolate->GetCurrentContext()).FromJust();
+		return true;
+	}
+};
+
+template <>
+struct NativeArgument<double>
+{
+	typedef double Type;
+	enum { isOptional = false };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, double* result)
+	{
+		if (!value->IsNumber())
+			return false;
+		*result = value->NumberValue(isolate->GetCurrentContext()).FromJust();
+		return true;
+	}
+};
+
+template <>
+struct NativeArgument<bool>
+{
+	typedef bool Type;
+	enum { isOptional = false };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, bool* result)
+	{
+		if (!value->IsBoolean())
+			return false;
+		*result = value->BooleanValue(isolate->GetCurrentContext()).FromJust();
+		return true;
+	}
+};
+
+template <>
+struct NativeArgument<QString>
+{
+	typedef QString Type;
+	enum { isOptional = false };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, QString* result);
+};
+
+template <>
+struct NativeArgument<Latin1String>
+{
+	typedef Latin1String Type;
+	enum { isOptional = false };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, Latin1String* result);
+};
+
+// ByteArray object or ArrayBuffer, data is not copied and is valid during the call only
+template <>
+struct NativeArgument<QByteArray>
+{
+	typedef QByteArray Type;
+	enum { isOptional = false };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, QByteArray* result);
+};
+
+// Any value, native checks the type itself
+template <>
+struct NativeArgument<v8::Local<v8::Value> >
+{
+	typedef v8::Local<v8::Value> Type;
+	enum { isOptional = false };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, v8::Local<v8::Value>* result)
+	{
+		*result = value;
+		return true;
+	}
+};
+
+template <typename T>
+struct NativeArgument<Optional<T> >
+{
+	typedef Optional<T> Type;
+	enum { isOptional = true };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, Optional<T>* result)
+	{
+		if (value->IsUndefined())
+			return true;
+		result->isSet = true;
+		return NativeArgument<T>::convert(isolate, value, &result->value);
+	}
+};
+
+template <typename T>
+struct NativeArgument<LenientOptional<T> >
+{
+	typedef LenientOptional<T> Type;
+	enum { isOptional = true };
+
+	static bool convert(v8::Isolate* isolate, v8::Local<v8::Value> value, LenientOptional<T>* result)
+	{
+		if (!value->IsUndefined())
+			result->isSet = NativeArgument<T>::convert(isolate, value, &result->value);
+		return true;
+	}
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Conversion of native return value
+///
+////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+struct NativeReturn;
+
+template <>
+struct NativeReturn<int>
+{
+	static void set(const v8::FunctionCallbackInfo<v8::Value>& args, int value) { args.GetReturnValue().Set(value); }
+};
+
+template <>
+struct NativeReturn<double>
+{
+	static void set(const v8::FunctionCallbackInfo<v8::Value>& args, double value) { args.GetReturnValue().Set(value); }
+};
+
+template <>
+struct NativeReturn<bool>
+{
+	static void set(const v8::FunctionCallbackInfo<v8::Value>& args, bool value) { args.GetReturnValue().Set(value); }
+};
+
+template <>
+struct NativeReturn<QString>
+{
+	static void set(const v8::FunctionCallbackInfo<v8::Value>& args, const QString& value);
+};
+
+template <>
+struct NativeReturn<Latin1String>
+{
+	static void set(const v8::FunctionCallbackInfo<v8::Value>& args, const Latin1String& value);
+};
+
+// Returned as new ByteArray object
+template <>
+struct NativeReturn<QByteArray>
+{
+	static void set(const v8::FunctionCallbackInfo<v8::Value>& args, const QByteArray& value);
+};
+
+template <typename T>
+struct NativeReturn<v8::Local<T> >
+{
+	static void set(const v8::FunctionCallbackInfo<v8::Value>& args, v8::Local<T> value) { args.GetReturnValue().Set(value); }
+};
+
+
+// Size of argument or result counted by NativeStatistics, values without data count as zero
+template <typename T>
+inline size_t nativeByteSize(const T&) { return 0; }
+
+inline size_t nativeByteSize(const QString& value) { return value.size() * sizeof(QChar); }
+inline size_t nativeByteSize(const Latin1String& value) { return value.data.size(); }
+inline size_t nativeByteSize(const QByteArray& value) { return value.size(); }
+
+template <typename T>
+inline size_t nativeByteSize(const Optional<T>& value) { return value.isSet ? nativeByteSize(value.value) : 0; }
+
+template <typename T>
+inline size_t nativeByteSize(const LenientOptional<T>& value) { return value.isSet ? nativeByteSize(value.value) : 0; }
+
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Generation of FunctionCallback from native signature
+///
+////////////////////////////////////////////////////////////////////////////////////
+template <int... I>
+struct NativeIndices {};
+
+template <int N, int... I>
+struct NativeIndexBuilder : NativeIndexBuilder<N - 1, N - 1, I...> {};
+
+template <int... I>
+struct NativeIndexBuilder<0, I...>
+{
+	typedef NativeIndices<I...> Type;
+};
+
+// Number of arguments before the first optional one
+template <typename... A>
+struct NativeRequiredCount;
+
+template <>
+struct NativeRequiredCount<>
+{
+	enum { value = 0 };
+};
+
+template <typename A, typename... Rest>
+struct NativeRequiredCount<A, Rest...>
+{
+	enum { value = NativeArgument<A>::isOptional ? 0 : 1 + NativeRequiredCount<Rest...>::value };
+};
+
+template <typename R>
+struct NativeInvoker
+{
+	template <typename F, typename... V>
+	static void invoke(const v8::FunctionCallbackInfo<v8::Value>& args, NativeCall& call, NativeStatistics::Sample* sample, F function, V&... values)
+	{
+		if (sample != NULL)
+			sample->startWork();
+		R result = function(call, values...);
+		if (sample != NULL) {
+			sample->finishWork();
+			sample->bytesOut = nativeByteSize(result);
+		}
+
+		if (!call.isFailed())
+			NativeReturn<R>::set(args, result);
+	}
+};
+
+template <>
+struct NativeInvoker<void>
+{
+	template <typename F, typename... V>
+	static void invoke(const v8::FunctionCallbackInfo<v8::Value>& args, NativeCall& call, NativeStatistics::Sample* sample, F function, V&... values)
+	{
+		if (sample != NULL)
+			sample->startWork();
+		function(call, values...);
+		if (sample != NULL)
+			sample->finishWork();
+	}
+};
+
+template <typename F>
+struct NativeFunction;
+
+template <typename R, typename... A>
+struct NativeFunction<R (*)(NativeCall&, A...)>
+{
+	typedef R (*Function)(NativeCall&, A...);
+
+	template <Function function>
+	static void callback(const v8::FunctionCallbackInfo<v8::Value>& args)
+	{
+		invoke<function>(args, typename NativeIndexBuilder<sizeof...(A)>::Type());
+	}
+
+	// Index of native in NativeStatistics, set when template is created
+	template <Function function>
+	static QBasicAtomicInt& statisticsIndex()
+	{
+		// Constant initialized, safe to reach from several engine threads at once
+		static QBasicAtomicInt index = Q_BASIC_ATOMIC_INITIALIZER(-1);
+		return index;
+	}
+
+private:
+	template <Function function, int... I>
+	static void invoke(const v8::FunctionCallbackInfo<v8::Value>& args, NativeIndices<I...>)
+	{
+		// Timing starts before argument conversion, only when collection is enabled
+		NativeStatistics* statistics = NativeStatistics::current(args.GetIsolate());
+		NativeStatistics::Sample sample;
+		NativeStatistics::Sample* measuredSample = NULL;
+		if (statistics != NULL) {
+			sample.start();
+			measuredSample = &sample;
+		}
+
+		if (args.Length() < NativeRequiredCount<A...>::value) {
+			Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentCount);
+			return;
+		}
+
+		// Arguments past the end read as undefined, conversion stops at first mismatch
+		std::tuple<typename NativeArgument<A>::Type...> values;
+		bool isConverted = true;
+		bool conversions[] = { true, (isConverted = isConverted && NativeArgument<A>::convert(args.GetIsolate(), args[I], &std::get<I>(values)))... };
+		(void)conversions;
+
+		if (!isConverted) {
+			Utility::throwException(args.GetIsolate(), Utility::ExceptionInvalidArgumentType);
+			return;
+		}
+
+		NativeCall call(args);
+		NativeInvoker<R>::invoke(args, call, measuredSample, function, std::get<I>(values)...);
+
+		if (statistics != NULL) {
+			size_t sizes[] = { 0, nativeByteSize(std::get<I>(values))... };
+			for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+				sample.bytesIn += sizes[i];
+			statistics->record(statisticsIndex<function>().load(), sample);
+		}
+	}
+};
+
+
+class NativeBinding
+{
+public:
+	// Property names used by natives, created once per isolate
+	enum PropertyName
+	{
+		NameBuffer,
+		NameValue,
+		NameFrequency,
+		NameGet,
+		NameSet,
+		NameWritable,
+		PropertyNameCount,
+	};
+
+	// Plain function, name identifies it in NativeStatistics
+	template <typename F, F native>
+	static v8::Local<v8::FunctionTemplate> function(v8::Isolate* isolate, const char* name, v8::Local<v8::Value> data = v8::Local<v8::Value>())
+	{
+		NativeFunction<F>::template statisticsIndex<native>().store(NativeStatistics::registerNative(name));
+		return v8::FunctionTemplate::New(isolate, &NativeFunction<F>::template callback<native>, data);
+	}
+
+	// Method callable only on instances of receiver, V8 rejects other receivers before native is called
+	template <typename F, F native>
+	static v8::Local<v8::FunctionTemplate> method(v8::Isolate* isolate, const char* name, v8::Local<v8::FunctionTemplate> receiver)
+	{
+		NativeFunction<F>::template statisticsIndex<native>().store(NativeStatistics::registerNative(name));
+		return v8::FunctionTemplate::New(isolate, &NativeFunction<F>::template callback<native>, v8::Local<v8::Value>(), v8::Signature::New(isolate, receiver));
+	}
+
+	// Hand-written callback counted by NativeStatistics, callback reports its sizes with NativeStatistics::addBytes
+	template <v8::FunctionCallback native>
+	static v8::Local<v8::FunctionTemplate> callback(v8::Isolate* isolate, const char* name, v8::Local<v8::Value> data = v8::Local<v8::Value>())
+	{
+		measuredCallbackIndex<native>().store(NativeStatistics::registerNative(name));
+		return v8::FunctionTemplate::New(isolate, &measuredCallback<native>, data);
+	}
+
+	// Cached property name, valid for isolate lifetime
+	static v8::Local<v8::String> name(v8::Isolate* isolate, PropertyName name);
+
+	// Release name cache stored in isolate, must be called before isolate is disposed
+	static void disposeNames(v8::Isolate* isolate);
+
+private:
+	NativeBinding() {}
+
+	template <v8::FunctionCallback native>
+	static QBasicAtomicInt& measuredCallbackIndex()
+	{
+		static QBasicAtomicInt index = Q_BASIC_ATOMIC_INITIALIZER(-1);
+		return index;
+	}
+
+	template <v8::FunctionCallback native>
+	static void measuredCallback(const v8::FunctionCallbackInfo<v8::Value>& args)
+	{
+		NativeStatistics* statistics = NativeStatistics::current(args.GetIsolate());
+		if (statistics == NULL) {
+			native(args);
+			return;
+		}
+
+		// Hand-written natives convert their own arguments, whole call counts as work
+		NativeStatistics::Sample sample;
+		NativeStatistics::Sample* previousSample = statistics->setActiveSample(&sample);
+		sample.start();
+		sample.startWork();
+		native(args);
+		sample.finishWork();
+		statistics->setActiveSample(previousSample);
+		statistics->record(measuredCallbackIndex<native>().load(), sample);
+	}
+};
+
+#endif // NATIVEBINDING_H
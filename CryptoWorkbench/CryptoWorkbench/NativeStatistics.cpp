@@ -0,0 +1,103 @@
+#include "NativeStatistics.h"
+#include <QStringList>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QtAlgorithms>
+
+using namespace v8;
+
+static QElapsedTimer startedTimer()
+{
+	QElapsedTimer timer;
+	timer.start();
+	return timer;
+}
+
+// Started before any engine exists, all samples share one time base
+static const QElapsedTimer clock = startedTimer();
+
+// Names of registered natives, index in list is index of native
+static QMutex nativeNamesMutex;
+static QStringList nativeNames;
+
+static bool isSlower(const NativeStatistics::Counter& first, const NativeStatistics::Counter& second)
+{
+	return first.totalTime > second.totalTime;
+}
+
+
+qint64 NativeStatistics::Counter::percentile(double share) const
+{
+	quint64 limit = quint64(callCount * share);
+	quint64 count = 0;
+	for (int i = 0; i < histogram.count(); i++) {
+		count += histogram.at(i);
+		if (count >= limit && count > 0)
+			return qint64(1) << i;
+	}
+	return 0;
+}
+
+int NativeStatistics::registerNative(const QString& name)
+{
+	QMutexLocker locker(&nativeNamesMutex);
+	int index = nativeNames.indexOf(name);
+	if (index < 0) {
+		nativeNames.append(name);
+		index = nativeNames.count() - 1;
+	}
+	return index;
+}
+
+qint64 NativeStatistics::now()
+{
+	return clock.nsecsElapsed();
+}
+
+void NativeStatistics::record(int index, const Sample& sample)
+{
+	if (index < 0)
+		return;
+	if (index >= entries.count())
+		entries.resize(index + 1);
+
+	qint64 totalTime = now() - sample.startTime;
+	Counter& counter = entries[index];
+	counter.callCount++;
+	counter.bytesIn += sample.bytesIn;
+	counter.bytesOut += sample.bytesOut;
+	counter.totalTime += totalTime;
+	counter.workTime += sample.workEndTime - sample.workStartTime;
+
+	// Bucket i holds calls shorter than 2^i us
+	int bucket = 0;
+	for (qint64 micros = totalTime / 1000; micros > 0 && bucket < BucketCount - 1; micros >>= 1)
+		bucket++;
+	counter.histogram[bucket]++;
+}
+
+QList<NativeStatistics::Counter> NativeStatistics::counters() const
+{
+	QStringList names;
+	{
+		QMutexLocker locker(&nativeNamesMutex);
+		names = nativeNames;
+	}
+
+	QList<Counter> result;
+	for (int i = 0; i < entries.count(); i++) {
+		if (entries.at(i).callCount == 0)
+			continue;
+		Counter counter = entries.at(i);
+		counter.name = names.value(i);
+		result.append(counter);
+	}
+
+	qSort(result.begin(), result.end(), isSlower);
+	return result;
+}
+
+void NativeStatistics::clear()
+{
+	entries.clear();
+}
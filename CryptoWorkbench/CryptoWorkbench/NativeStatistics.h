@@ -0,0 +1,97 @@
+#ifndef NATIVESTATISTICS_H
+#define NATIVESTATISTICS_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QMetaType>
+#include "include/v8.h"
+#include "Utility.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Call counters of natives generated by NativeBinding, collected per isolate.
+/// Collection is enabled by storing collector into isolate data slot,
+/// natives check the slot once per call and do nothing more when it is empty.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class NativeStatistics
+{
+public:
+	// Latency buckets in powers of two microseconds, last bucket holds all slower calls
+	enum { BucketCount = 20 };
+
+	struct Counter
+	{
+		Counter() : callCount(0), bytesIn(0), bytesOut(0), totalTime(0), workTime(0), histogram(BucketCount, 0) {}
+
+		// Upper bound in microseconds of latency of provided share of calls
+		qint64 percentile(double share) const;
+
+		QString name;
+		quint64 callCount;
+		quint64 bytesIn;
+		quint64 bytesOut;
+
+		// Times in ns, difference of total and work time is spent converting arguments and result
+		qint64 totalTime;
+		qint64 workTime;
+
+		QVector<quint64> histogram;
+	};
+
+	// Timestamps and sizes of one call
+	struct Sample
+	{
+		Sample() : startTime(0), workStartTime(0), workEndTime(0), bytesIn(0), bytesOut(0) {}
+
+		void start() { startTime = now(); }
+		void startWork() { workStartTime = now(); }
+		void finishWork() { workEndTime = now(); }
+
+		qint64 startTime;
+		qint64 workStartTime;
+		qint64 workEndTime;
+		size_t bytesIn;
+		size_t bytesOut;
+	};
+
+	NativeStatistics() : activeSample(NULL) {}
+
+	// Index of native with provided name, shared by all engines of the process
+	static int registerNative(const QString& name);
+
+	// Collector of isolate, NULL when collection is disabled
+	static NativeStatistics* current(v8::Isolate* isolate) { return static_cast<NativeStatistics*>(isolate->GetData(Utility::DataSlotNativeStatistics)); }
+
+	// Monotonic time in ns
+	static qint64 now();
+
+	void record(int index, const Sample& sample);
+
+	// Sizes reported by hand-written callback, added to its sample while it runs
+	static void addBytes(v8::Isolate* isolate, size_t bytesIn, size_t bytesOut)
+	{
+		NativeStatistics* statistics = current(isolate);
+		if (statistics != NULL && statistics->activeSample != NULL) {
+			statistics->activeSample->bytesIn += bytesIn;
+			statistics->activeSample->bytesOut += bytesOut;
+		}
+	}
+
+	// Sample of running hand-written callback, returns previous one so nested calls can restore it
+	Sample* setActiveSample(Sample* sample) { Sample* previous = activeSample; activeSample = sample; return previous; }
+
+	// Natives called at least once, slowest first
+	QList<Counter> counters() const;
+
+	void clear();
+
+private:
+	QVector<Counter> entries;
+	Sample* activeSample;
+};
+
+Q_DECLARE_METATYPE(NativeStatistics::Counter)
+
+#endif // NATIVESTATISTICS_H
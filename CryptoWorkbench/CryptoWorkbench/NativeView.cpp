@@ -0,0 +1,92 @@
+#include "NativeView.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QCheckBox>
+
+// Columns of native table
+enum NativeColumn
+{
+	ColumnName,
+	ColumnCalls,
+	ColumnTotal,
+	ColumnConversion,
+	ColumnBytesIn,
+	ColumnBytesOut,
+	ColumnMedian,
+	ColumnSlowest,
+	ColumnCount,
+};
+
+static QString formatTime(qint64 nanoseconds)
+{
+	return QString::number(nanoseconds / 1e6, 'f', 3);
+}
+
+static QString formatSize(quint64 bytes)
+{
+	return QString::number(bytes / 1024.0, 'f', 1);
+}
+
+// Call count of every latency bucket, empty buckets are left out
+static QString formatHistogram(const NativeStatistics::Counter& counter)
+{
+	QStringList lines;
+	for (int i = 0; i < counter.histogram.count(); i++) {
+		if (counter.histogram.at(i) == 0)
+			continue;
+		QString bound = (i == counter.histogram.count() - 1) ? QString(">= %1 us").arg(qint64(1) << (i - 1)) : QString("< %1 us").arg(qint64(1) << i);
+		lines.append(QString("%1: %2").arg(bound).arg(counter.histogram.at(i)));
+	}
+	return lines.join("\n");
+}
+
+
+NativeView::NativeView(QWidget* parent)
+	: QWidget(parent)
+{
+	QVBoxLayout* layout = new QVBoxLayout(this);
+	QHBoxLayout* toolbarLayout = new QHBoxLayout();
+
+	nativeTree = new QTreeWidget(this);
+	nativeTree->setColumnCount(ColumnCount);
+	nativeTree->setHeaderLabels(QStringList() << "Native" << "Calls" << "Total ms" << "Conversion ms" << "In KB" << "Out KB" << "p50 us" << "p99 us");
+	nativeTree->setRootIsDecorated(false);
+	nativeTree->setUniformRowHeights(true);
+	nativeTree->header()->setStretchLastSection(false);
+	nativeTree->header()->setSectionResizeMode(ColumnName, QHeaderView::Stretch);
+
+	// Collection is off by default, natives then skip all bookkeeping
+	collectCheck = new QCheckBox("Co&llect native statistics", this);
+	connect(collectCheck, &QCheckBox::toggled, this, &NativeView::collectionToggled);
+	toolbarLayout->addWidget(collectCheck);
+	toolbarLayout->addStretch(1);
+
+	layout->setMargin(0);
+	layout->addLayout(toolbarLayout);
+	layout->addWidget(nativeTree);
+}
+
+void NativeView::setCounters(const QList<NativeStatistics::Counter>& counters)
+{
+	nativeTree->clear();
+
+	QList<QTreeWidgetItem*> items;
+	foreach (const NativeStatistics::Counter& counter, counters) {
+		QTreeWidgetItem* item = new QTreeWidgetItem();
+		item->setText(ColumnName, counter.name);
+		item->setText(ColumnCalls, QString::number(counter.callCount));
+		item->setText(ColumnTotal, formatTime(counter.totalTime));
+		item->setText(ColumnConversion, formatTime(counter.totalTime - counter.workTime));
+		item->setText(ColumnBytesIn, formatSize(counter.bytesIn));
+		item->setText(ColumnBytesOut, formatSize(counter.bytesOut));
+		item->setText(ColumnMedian, QString::number(counter.percentile(0.5)));
+		item->setText(ColumnSlowest, QString::number(counter.percentile(0.99)));
+		item->setToolTip(ColumnName, formatHistogram(counter));
+		for (int i = ColumnCalls; i < ColumnCount; i++)
+			item->setTextAlignment(i, Qt::AlignRight | Qt::AlignVCenter);
+		items.append(item);
+	}
+	nativeTree->addTopLevelItems(items);
+}
@@ -0,0 +1,32 @@
+#ifndef NATIVEVIEW_H
+#define NATIVEVIEW_H
+
+#include <QWidget>
+#include "NativeStatistics.h"
+
+class QTreeWidget;
+class QCheckBox;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Side panel with call counters of natives recorded during last run
+///
+////////////////////////////////////////////////////////////////////////////////////
+class NativeView : public QWidget
+{
+	Q_OBJECT
+
+public:
+	NativeView(QWidget* parent = 0);
+
+	void setCounters(const QList<NativeStatistics::Counter>& counters);
+
+signals:
+	void collectionToggled(bool isEnabled);
+
+private:
+	QTreeWidget* nativeTree;
+	QCheckBox* collectCheck;
+};
+
+#endif // NATIVEVIEW_H
@@ -0,0 +1,21 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <QString>
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Receiver of text written by script through Output object
+/// Called from thread running the script, chunks arrive in order
+///
+////////////////////////////////////////////////////////////////////////////////////
+class OutputSink
+{
+public:
+	virtual ~OutputSink() {}
+
+	// Returns false when chunk could not be written, script gets an exception
+	virtual bool write(const QString& chunk) = 0;
+};
+
+#endif // OUTPUTSINK_H
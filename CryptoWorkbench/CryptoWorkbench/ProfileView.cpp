@@ -0,0 +1,141 @@
+#include "ProfileView.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QTabWidget>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QPushButton>
+#include <QFileDialog>
+#include <QFile>
+#include <algorithm>
+
+// Columns of profile tables
+enum ProfileColumn
+{
+	ColumnFunction,
+	ColumnSelfTime,
+	ColumnSelfPercent,
+	ColumnTotalTime,
+	ColumnTotalPercent,
+	ColumnLocation,
+	ColumnCount,
+};
+
+// Orders child indices by time, longest first
+struct NodeTimeGreater
+{
+	NodeTimeGreater(const QVector<ScriptProfile::Node>& profileNodes, bool isSelfTime) : nodes(profileNodes), useSelfTime(isSelfTime) {}
+
+	bool operator()(int a, int b) const
+	{
+		if (useSelfTime)
+			return nodes.at(a).selfTime > nodes.at(b).selfTime;
+		return nodes.at(a).totalTime > nodes.at(b).totalTime;
+	}
+
+	const QVector<ScriptProfile::Node>& nodes;
+	bool useSelfTime;
+};
+
+
+ProfileView::ProfileView(QWidget* parent)
+	: QWidget(parent)
+{
+	QVBoxLayout* layout = new QVBoxLayout(this);
+	QHBoxLayout* toolbarLayout = new QHBoxLayout();
+
+	summaryLabel = new QLabel(this);
+	toolbarLayout->addWidget(summaryLabel, 1);
+
+	buttonExport = new QPushButton("E&xport...", this);
+	buttonExport->setMinimumHeight(30);
+	buttonExport->setEnabled(false);
+	connect(buttonExport, &QPushButton::clicked, this, &ProfileView::exportClicked);
+	toolbarLayout->addWidget(buttonExport);
+
+	QTabWidget* tabs = new QTabWidget(this);
+	topDownTree = createTree();
+	bottomUpTree = createTree();
+	tabs->addTab(topDownTree, "Top Down");
+	tabs->addTab(bottomUpTree, "Bottom Up");
+
+	layout->setMargin(0);
+	layout->addLayout(toolbarLayout);
+	layout->addWidget(tabs);
+}
+
+void ProfileView::setProfile(const ScriptProfile& scriptProfile)
+{
+	profile = scriptProfile;
+
+	summaryLabel->setText(QString("Profile: %1 ms").arg(profile.duration(), 0, 'f', 1));
+	buttonExport->setEnabled(!profile.isEmpty());
+
+	fillTree(topDownTree, profile.topDown(), false);
+	fillTree(bottomUpTree, profile.bottomUp(), true);
+}
+
+void ProfileView::exportClicked()
+{
+	QString fileName = QFileDialog::getSaveFileName(this, tr("Export Profile"), "../scripts/", tr("CPU Profiles (*.cpuprofile)"));
+	if (fileName.isEmpty())
+		return;
+
+	QFile file(fileName);
+	if (file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		file.write(profile.toJson());
+}
+
+QTreeWidget* ProfileView::createTree()
+{
+	QTreeWidget* tree = new QTreeWidget(this);
+	tree->setColumnCount(ColumnCount);
+	tree->setHeaderLabels(QStringList() << "Function" << "Self ms" << "Self %" << "Total ms" << "Total %" << "Location");
+	tree->setUniformRowHeights(true);
+	tree->header()->setStretchLastSection(false);
+	tree->header()->setSectionResizeMode(ColumnFunction, QHeaderView::Stretch);
+	return tree;
+}
+
+void ProfileView::fillTree(QTreeWidget* tree, const QVector<ScriptProfile::Node>& nodes, bool isSortedBySelfTime)
+{
+	tree->clear();
+	if (nodes.isEmpty())
+		return;
+
+	// Root only groups everything else
+	QVector<int> children = nodes.first().children;
+	std::sort(children.begin(), children.end(), NodeTimeGreater(nodes, isSortedBySelfTime));
+
+	QList<QTreeWidgetItem*> items;
+	for (int i = 0; i < children.count(); i++)
+		items.append(createItem(nodes, children.at(i), isSortedBySelfTime));
+	tree->addTopLevelItems(items);
+
+	if (!isSortedBySelfTime)
+		tree->expandToDepth(1);
+}
+
+QTreeWidgetItem* ProfileView::createItem(const QVector<ScriptProfile::Node>& nodes, int index, bool isSortedBySelfTime)
+{
+	const ScriptProfile::Node& node = nodes.at(index);
+	double duration = qMax(profile.duration(), 0.001);
+
+	QTreeWidgetItem* item = new QTreeWidgetItem();
+	item->setText(ColumnFunction, node.functionName);
+	item->setText(ColumnSelfTime, QString::number(node.selfTime, 'f', 2));
+	item->setText(ColumnSelfPercent, QString::number(node.selfTime * 100.0 / duration, 'f', 1));
+	item->setText(ColumnTotalTime, QString::number(node.totalTime, 'f', 2));
+	item->setText(ColumnTotalPercent, QString::number(node.totalTime * 100.0 / duration, 'f', 1));
+	item->setText(ColumnLocation, node.location());
+	for (int column = ColumnSelfTime; column <= ColumnTotalPercent; column++)
+		item->setTextAlignment(column, Qt::AlignRight | Qt::AlignVCenter);
+
+	QVector<int> children = node.children;
+	std::sort(children.begin(), children.end(), NodeTimeGreater(nodes, isSortedBySelfTime));
+	for (int i = 0; i < children.count(); i++)
+		item->addChild(createItem(nodes, children.at(i), isSortedBySelfTime));
+
+	return item;
+}
@@ -0,0 +1,42 @@
+#ifndef PROFILEVIEW_H
+#define PROFILEVIEW_H
+
+#include <QWidget>
+#include "ScriptProfile.h"
+
+class QLabel;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QPushButton;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Side panel showing CPU profile of last run as top-down and bottom-up tables
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ProfileView : public QWidget
+{
+	Q_OBJECT
+
+public:
+	ProfileView(QWidget* parent = 0);
+
+	void setProfile(const ScriptProfile& scriptProfile);
+
+private slots:
+	void exportClicked();
+
+private:
+	QTreeWidget* createTree();
+	void fillTree(QTreeWidget* tree, const QVector<ScriptProfile::Node>& nodes, bool isSortedBySelfTime);
+	QTreeWidgetItem* createItem(const QVector<ScriptProfile::Node>& nodes, int index, bool isSortedBySelfTime);
+
+private:
+	ScriptProfile profile;
+	QLabel* summaryLabel;
+	QTreeWidget* topDownTree;
+	QTreeWidget* bottomUpTree;
+	QPushButton* buttonExport;
+};
+
+#endif // PROFILEVIEW_H
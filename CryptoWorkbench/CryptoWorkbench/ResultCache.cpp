@@ -0,0 +1,136 @@
+#include "ResultCache.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+// Identifies result files, changes whenever file layout changes
+static const quint32 ResultFileMagic = 0x43575231;
+
+
+ResultCache::ResultCache(const QString& directory, qint64 maxSize)
+	: resultDirectory(directory), maxCacheSize(maxSize)
+{
+	if (!resultDirectory.endsWith('/'))
+		resultDirectory.append('/');
+	QDir().mkpath(resultDirectory);
+}
+
+QByteArray ResultCache::runKey(const QStringList& inputs)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha256);
+	for (int i = 0; i < inputs.count(); i++) {
+		const QString& input = inputs.at(i);
+		QByteArray length = QByteArray::number(input.size());
+		hash.addData(length.append(':'));
+		hash.addData(reinterpret_cast<const char*>(input.constData()), input.size() * sizeof(QChar));
+	}
+	return hash.result().toHex();
+}
+
+bool ResultCache::find(const QByteArray& key, ScriptResult* result) const
+{
+	QString filePath = resultFilePath(key);
+	QFile file(filePath);
+	if (!file.open(QFile::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	quint32 magic;
+	QByteArray fileKey;
+	qint32 fileCount;
+	stream >> magic >> fileKey >> fileCount;
+
+	// File written by other version
+	if (stream.status() != QDataStream::Ok || magic != ResultFileMagic || fileKey != key || fileCount < 0)
+		return false;
+
+	// Any changed, new or missing file invalidates result
+	for (int i = 0; i < fileCount; i++) {
+		QString filePath;
+		QByteArray contentHash;
+		stream >> filePath >> contentHash;
+		if (stream.status() != QDataStream::Ok || fileHash(filePath) != contentHash)
+			return false;
+	}
+
+	ScriptResult storedResult;
+	stream >> storedResult;
+	if (stream.status() != QDataStream::Ok)
+		return false;
+
+	file.close();
+	markUsed(filePath);
+
+	storedResult.setFromCache(true);
+	*result = storedResult;
+	return true;
+}
+
+bool ResultCache::store(const QByteArray& key, const QStringList& filePaths, const ScriptResult& result) const
+{
+	// Engines of batch or daemon may store the same key at once, readers see only complete files
+	QSaveFile file(resultFilePath(key));
+	if (!file.open(QFile::WriteOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream << ResultFileMagic << key << qint32(filePaths.count());
+	for (int i = 0; i < filePaths.count(); i++)
+		stream << filePaths.at(i) << fileHash(filePaths.at(i));
+	stream << result;
+
+	if (stream.status() != QDataStream::Ok) {
+		file.cancelWriting();
+		return false;
+	}
+	if (!file.commit())
+		return false;
+
+	evict();
+	return true;
+}
+
+QString ResultCache::resultFilePath(const QByteArray& key) const
+{
+	return resultDirectory + QString::fromLatin1(key) + ".result";
+}
+
+void ResultCache::markUsed(const QString& filePath) const
+{
+	// Rewriting magic moves modification time, eviction order follows it
+	QFile file(filePath);
+	if (!file.open(QFile::ReadWrite))
+		return;
+
+	QDataStream stream(&file);
+	stream << ResultFileMagic;
+}
+
+void ResultCache::evict() const
+{
+	// Directory may be shared by several engines, sizes are read again every time
+	QFileInfoList files = QDir(resultDirectory).entryInfoList(QStringList("*.result"), QDir::Files, QDir::Time);
+
+	// Newest files are kept, result larger than the whole cache is dropped right away
+	qint64 totalSize = 0;
+	for (int i = 0; i < files.count(); i++) {
+		totalSize += files.at(i).size();
+		if (totalSize > maxCacheSize && QFile::remove(files.at(i).absoluteFilePath()))
+			totalSize -= files.at(i).size();
+	}
+}
+
+QByteArray ResultCache::fileHash(const QString& filePath)
+{
+	// Missing file hashes to empty value, creating it later invalidates result
+	QFile file(filePath);
+	if (!file.open(QFile::ReadOnly))
+		return QByteArray();
+
+	QCryptographicHash hash(QCryptographicHash::Sha256);
+	hash.addData(&file);
+	return hash.result();
+}
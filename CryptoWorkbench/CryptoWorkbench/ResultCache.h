@@ -0,0 +1,44 @@
+#ifndef RESULTCACHE_H
+#define RESULTCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include "ScriptResult.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Results of earlier runs stored on disk under hash of everything the run read.
+/// Key covers script, workspace and core library, content of files read by
+/// the run is hashed when result is stored and checked again when it is found.
+/// Least recently used results are removed when directory grows above its limit.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ResultCache
+{
+public:
+	// Results are kept as <key>.result files in directory, taking at most maxSize bytes
+	ResultCache(const QString& directory, qint64 maxSize);
+
+	// Hex SHA-256 of run inputs, inputs are length prefixed so their boundaries count
+	// Texts are hashed as UTF-16 without being copied
+	static QByteArray runKey(const QStringList& inputs);
+
+	// Result stored under key when every file read by that run still has the same content
+	bool find(const QByteArray& key, ScriptResult* result) const;
+
+	// Store result together with content hashes of files read by the run
+	bool store(const QByteArray& key, const QStringList& filePaths, const ScriptResult& result) const;
+
+private:
+	QString resultFilePath(const QByteArray& key) const;
+	void markUsed(const QString& filePath) const;
+	void evict() const;
+	static QByteArray fileHash(const QString& filePath);
+
+private:
+	QString resultDirectory;
+	qint64 maxCacheSize;
+};
+
+#endif // RESULTCACHE_H
@@ -0,0 +1,19 @@
+#include "ScriptCell.h"
+#include <QStringList>
+
+QList<ScriptCell> ScriptCell::split(const QString& script)
+{
+	QList<ScriptCell> cells;
+	QStringList lines = script.split('\n');
+
+	// Text before the first marker forms a cell of its own
+	int firstLine = 0;
+	for (int i = 1; i <= lines.count(); i++) {
+		if (i < lines.count() && !isMarker(lines.at(i)))
+			continue;
+
+		cells.append(ScriptCell(QStringList(lines.mid(firstLine, i - firstLine)).join("\n"), firstLine));
+		firstLine = i;
+	}
+	return cells;
+}
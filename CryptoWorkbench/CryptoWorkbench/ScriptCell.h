@@ -0,0 +1,29 @@
+#ifndef SCRIPTCELL_H
+#define SCRIPTCELL_H
+
+#include <QString>
+#include <QList>
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Part of script run as one step in cell mode
+/// Cells are delimited by lines starting with marker comment //%%
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ScriptCell
+{
+public:
+	ScriptCell() : line(0) {}
+	ScriptCell(const QString& cellCode, int firstLine) : code(cellCode), line(firstLine) {}
+
+	// True for line opening a new cell
+	static bool isMarker(const QString& line) { return line.startsWith("//%%"); }
+
+	// Split script into cells, marker line belongs to the cell it opens
+	static QList<ScriptCell> split(const QString& script);
+
+	QString code;
+	int line;
+};
+
+#endif // SCRIPTCELL_H
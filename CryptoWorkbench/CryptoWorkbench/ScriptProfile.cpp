@@ -0,0 +1,179 @@
+#include "ScriptProfile.h"
+#include <QHash>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include "Utility.h"
+
+using namespace v8;
+
+
+static QString functionKey(const ScriptProfile::Node& node)
+{
+	return QString("%1\n%2\n%3\n%4").arg(node.functionName).arg(node.url).arg(node.lineNumber).arg(node.columnNumber);
+}
+
+// Find child of bottom-up node representing same function, create it when missing
+static int childFor(QVector<ScriptProfile::Node>& tree, int parent, const ScriptProfile::Node& node)
+{
+	QString key = functionKey(node);
+	for (int i = 0; i < tree[parent].children.count(); i++) {
+		int child = tree[parent].children.at(i);
+		if (functionKey(tree.at(child)) == key)
+			return child;
+	}
+
+	ScriptProfile::Node child = node;
+	child.id = tree.count();
+	child.parent = parent;
+	child.children.clear();
+	child.hitCount = 0;
+	child.selfTime = 0.0;
+	child.totalTime = 0.0;
+	tree.append(child);
+	tree[parent].children.append(child.id);
+	return child.id;
+}
+
+
+QString ScriptProfile::Node::location() const
+{
+	if (url.isEmpty())
+		return QString();
+	return QString("%1:%2").arg(QFileInfo(url).fileName()).arg(lineNumber);
+}
+
+ScriptProfile::ScriptProfile(const CpuProfile* profile)
+	: startTime(profile->GetStartTime()), endTime(profile->GetEndTime())
+{
+	appendNode(profile->GetTopDownRoot(), -1);
+
+	for (int i = 0; i < profile->GetSamplesCount(); i++) {
+		samples.append(profile->GetSample(i)->GetNodeId());
+		timestamps.append(profile->GetSampleTimestamp(i));
+	}
+
+	computeTimes();
+}
+
+void ScriptProfile::appendNode(const CpuProfileNode* profileNode, int parent)
+{
+	Node node;
+	node.id = profileNode->GetNodeId();
+	node.functionName = Utility::toString(profileNode->GetFunctionName());
+	node.url = Utility::toString(profileNode->GetScriptResourceName());
+	node.scriptId = profileNode->GetScriptId();
+	node.lineNumber = profileNode->GetLineNumber();
+	node.columnNumber = profileNode->GetColumnNumber();
+	node.hitCount = profileNode->GetHitCount();
+	node.parent = parent;
+
+	if (node.functionName.isEmpty())
+		node.functionName = "(anonymous function)";
+
+	int index = nodes.count();
+	nodes.append(node);
+	if (parent >= 0)
+		nodes[parent].children.append(index);
+
+	for (int i = 0; i < profileNode->GetChildrenCount(); i++)
+		appendNode(profileNode->GetChild(i), index);
+}
+
+void ScriptProfile::computeTimes()
+{
+	unsigned totalHits = 0;
+	for (int i = 0; i < nodes.count(); i++)
+		totalHits += nodes.at(i).hitCount;
+
+	// Every tick stands for equal share of profile duration
+	double tickTime = totalHits > 0 ? duration() / totalHits : 0.0;
+	for (int i = 0; i < nodes.count(); i++) {
+		nodes[i].selfTime = nodes.at(i).hitCount * tickTime;
+		nodes[i].totalTime = nodes.at(i).selfTime;
+	}
+
+	// Children always follow their parent
+	for (int i = nodes.count() - 1; i > 0; i--)
+		nodes[nodes.at(i).parent].totalTime += nodes.at(i).totalTime;
+}
+
+QVector<ScriptProfile::Node> ScriptProfile::bottomUp() const
+{
+	QVector<Node> tree;
+	if (nodes.isEmpty())
+		return tree;
+
+	Node root = nodes.first();
+	root.id = 0;
+	root.children.clear();
+	tree.append(root);
+
+	for (int i = 1; i < nodes.count(); i++) {
+		const Node& node = nodes.at(i);
+
+		// Recursive calls are already part of total time of outermost call
+		bool isRecursive = false;
+		for (int caller = node.parent; caller > 0 && !isRecursive; caller = nodes.at(caller).parent)
+			isRecursive = functionKey(nodes.at(caller)) == functionKey(node);
+
+		if (node.selfTime <= 0.0 && isRecursive)
+			continue;
+
+		// Walk from the function up through its callers
+		int current = 0;
+		for (int frame = i; frame > 0; frame = nodes.at(frame).parent) {
+			current = childFor(tree, current, nodes.at(frame));
+			tree[current].hitCount += node.hitCount;
+			tree[current].selfTime += node.selfTime;
+			if (!isRecursive)
+				tree[current].totalTime += node.totalTime;
+		}
+	}
+	return tree;
+}
+
+QByteArray ScriptProfile::toJson() const
+{
+	QJsonArray nodeArray;
+	for (int i = 0; i < nodes.count(); i++) {
+		const Node& node = nodes.at(i);
+
+		// Positions are zero based in .cpuprofile, V8 reports them from one
+		QJsonObject callFrame;
+		callFrame.insert("functionName", i == 0 ? QString("(root)") : node.functionName);
+		callFrame.insert("scriptId", QString::number(node.scriptId));
+		callFrame.insert("url", node.url);
+		callFrame.insert("lineNumber", node.lineNumber - 1);
+		callFrame.insert("columnNumber", node.columnNumber - 1);
+
+		QJsonArray children;
+		for (int j = 0; j < node.children.count(); j++)
+			children.append(nodes.at(node.children.at(j)).id);
+
+		QJsonObject object;
+		object.insert("id", node.id);
+		object.insert("callFrame", callFrame);
+		object.insert("hitCount", static_cast<int>(node.hitCount));
+		object.insert("children", children);
+		nodeArray.append(object);
+	}
+
+	QJsonArray sampleArray;
+	QJsonArray timeDeltas;
+	qint64 previous = startTime;
+	for (int i = 0; i < samples.count(); i++) {
+		sampleArray.append(samples.at(i));
+		timeDeltas.append(timestamps.at(i) - previous);
+		previous = timestamps.at(i);
+	}
+
+	QJsonObject profile;
+	profile.insert("nodes", nodeArray);
+	profile.insert("startTime", startTime);
+	profile.insert("endTime", endTime);
+	profile.insert("samples", sampleArray);
+	profile.insert("timeDeltas", timeDeltas);
+	return QJsonDocument(profile).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,68 @@
+#ifndef SCRIPTPROFILE_H
+#define SCRIPTPROFILE_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <QMetaType>
+#include "include/v8-profiler.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Copy of V8 CPU profile taken while evaluating script, usable without isolate
+/// Times are in milliseconds
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ScriptProfile
+{
+public:
+	struct Node
+	{
+		Node() : id(0), scriptId(0), lineNumber(0), columnNumber(0), hitCount(0), parent(-1), selfTime(0.0), totalTime(0.0) {}
+
+		// Source location in "file:line" form, empty for native code
+		QString location() const;
+
+		int id;
+		QString functionName;
+		QString url;
+		int scriptId;
+		int lineNumber;
+		int columnNumber;
+		unsigned hitCount;
+		int parent;
+		QVector<int> children;
+		double selfTime;
+		double totalTime;
+	};
+
+	ScriptProfile() : startTime(0), endTime(0) {}
+	explicit ScriptProfile(const v8::CpuProfile* profile);
+
+	bool isEmpty() const { return nodes.isEmpty(); }
+	double duration() const { return (endTime - startTime) / 1000.0; }
+
+	// Call tree from root to leaves, root is the first node
+	const QVector<Node>& topDown() const { return nodes; }
+
+	// Tree of functions consuming time, children are their callers
+	QVector<Node> bottomUp() const;
+
+	// Profile in .cpuprofile format understood by Chrome DevTools and other tools
+	QByteArray toJson() const;
+
+private:
+	void appendNode(const v8::CpuProfileNode* profileNode, int parent);
+	void computeTimes();
+
+private:
+	QVector<Node> nodes;
+	QVector<int> samples;
+	QVector<qint64> timestamps;
+	qint64 startTime;
+	qint64 endTime;
+};
+
+Q_DECLARE_METATYPE(ScriptProfile)
+
+#endif // SCRIPTPROFILE_H
@@ -0,0 +1,173 @@
+#include "ScriptResult.h"
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QDataStream>
+
+// Shortest form of double that survives round trip for common values
+static QString numberString(double value)
+{
+	return QString::number(value, 'g', 15);
+}
+
+static QString csvField(const QString& text)
+{
+	if (!text.contains(',') && !text.contains('"') && !text.contains('\n') && !text.contains('\r'))
+		return text;
+
+	QString escaped = text;
+	escaped.replace("\"", "\"\"");
+	return "\"" + escaped + "\"";
+}
+
+static QString cellString(const QVariant& cell)
+{
+	if (cell.type() == QVariant::Double)
+		return numberString(cell.toDouble());
+	return cell.toString();
+}
+
+ScriptResult ScriptResult::fromBytes(const QByteArray& data)
+{
+	ScriptResult result(QString(), true);
+	result.resultType = TypeBytes;
+	result.byteData = data;
+	return result;
+}
+
+ScriptResult ScriptResult::fromTable(const QStringList& columns, const QList<QVariantList>& rows)
+{
+	ScriptResult result(QString(), true);
+	result.resultType = TypeTable;
+	result.tableColumns = columns;
+	result.tableRows = rows;
+	return result;
+}
+
+ScriptResult ScriptResult::fromNumbers(const QVector<double>& values)
+{
+	ScriptResult result(QString(), true);
+	result.resultType = TypeNumbers;
+	result.numberData = values;
+	return result;
+}
+
+bool ScriptResult::formatFromName(const QString& name, Format* format)
+{
+	static const char* names[] = { "text", "hex", "csv", "json" };
+
+	for (int i = 0; i < int(sizeof(names) / sizeof(names[0])); i++) {
+		if (name == names[i]) {
+			*format = static_cast<Format>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+QString ScriptResult::render(Format format) const
+{
+	if (format == FormatJson) {
+		QJsonValue value = toJson();
+		if (value.isArray())
+			return QString::fromUtf8(QJsonDocument(value.toArray()).toJson(QJsonDocument::Compact));
+
+		// Document can't hold scalar, wrap it and strip the brackets
+		QJsonArray wrapper;
+		wrapper.append(value);
+		QByteArray wrapped = QJsonDocument(wrapper).toJson(QJsonDocument::Compact);
+		return QString::fromUtf8(wrapped.mid(1, wrapped.size() - 2));
+	}
+
+	switch (resultType) {
+		case TypeText:
+			return (format == FormatHex) ? QString::fromLatin1(resultData.toUtf8().toHex()) : resultData;
+		case TypeBytes:
+			// Text matches ByteArray.toString of the returned bytes
+			return (format == FormatHex) ? QString::fromLatin1(byteData.toHex()) : QString::fromUtf8(byteData);
+		case TypeTable:
+			return renderCsv();
+		case TypeNumbers: {
+			// Text matches Array.prototype.toString, CSV puts every value on its own line
+			QStringList values;
+			values.reserve(numberData.size());
+			for (int i = 0; i < numberData.size(); i++)
+				values.append(numberString(numberData.at(i)));
+			return values.join(format == FormatCsv ? "\n" : ",");
+		}
+	}
+	return resultData;
+}
+
+QJsonValue ScriptResult::toJson() const
+{
+	switch (resultType) {
+		case TypeText:
+			return resultData;
+		case TypeBytes:
+			return QString::fromLatin1(byteData.toHex());
+		case TypeTable: {
+			// Rows become objects when columns are named
+			QJsonArray rows;
+			foreach (const QVariantList& row, tableRows) {
+				if (tableColumns.isEmpty()) {
+					rows.append(QJsonArray::fromVariantList(row));
+					continue;
+				}
+				QJsonObject object;
+				for (int i = 0; i < row.size() && i < tableColumns.size(); i++)
+					object.insert(tableColumns.at(i), QJsonValue::fromVariant(row.at(i)));
+				rows.append(object);
+			}
+			return rows;
+		}
+		case TypeNumbers: {
+			QJsonArray values;
+			for (int i = 0; i < numberData.size(); i++)
+				values.append(numberData.at(i));
+			return values;
+		}
+	}
+	return resultData;
+}
+
+QDataStream& operator<<(QDataStream& stream, const ScriptResult& result)
+{
+	stream << qint32(result.resultType) << result.isResultValid << result.resultData << result.byteData
+		   << result.tableColumns << result.tableRows << result.numberData;
+	return stream;
+}
+
+QDataStream& operator>>(QDataStream& stream, ScriptResult& result)
+{
+	qint32 type;
+	stream >> type >> result.isResultValid >> result.resultData >> result.byteData
+		   >> result.tableColumns >> result.tableRows >> result.numberData;
+
+	if (type < ScriptResult::TypeText || type > ScriptResult::TypeNumbers)
+		stream.setStatus(QDataStream::ReadCorruptData);
+	result.resultType = static_cast<ScriptResult::Type>(type);
+	result.isResultFromCache = false;
+	return stream;
+}
+
+QString ScriptResult::renderCsv() const
+{
+	QStringList lines;
+	lines.reserve(tableRows.size() + 1);
+
+	if (!tableColumns.isEmpty()) {
+		QStringList header;
+		foreach (const QString& column, tableColumns)
+			header.append(csvField(column));
+		lines.append(header.join(","));
+	}
+
+	foreach (const QVariantList& row, tableRows) {
+		QStringList fields;
+		foreach (const QVariant& cell, row)
+			fields.append(csvField(cellString(cell)));
+		lines.append(fields.join(","));
+	}
+	return lines.join("\n");
+}
@@ -2,28 +2,96 @@
 #define SCRIPTRESULT_H
 
 #include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QVariant>
+#include <QJsonValue>
+#include <QMetaType>
+
+class QDataStream;
 
 ////////////////////////////////////////////////////////////////////////////////////
 ///
 /// Class representing the result of javascript evaluation
+/// Successful result is text or typed payload rendered on demand
 ///
 ////////////////////////////////////////////////////////////////////////////////////
 class ScriptResult
 {
 public:
+	enum Type
+	{
+		TypeText,
+		TypeBytes,
+		TypeTable,
+		TypeNumbers,
+	};
+
+	enum Format
+	{
+		FormatText,
+		FormatHex,
+		FormatCsv,
+		FormatJson,
+	};
+
+	ScriptResult() : resultType(TypeText), isResultValid(false), isResultFromCache(false) {}
+
 	static ScriptResult error(const QString& message) { return ScriptResult(message, false); }
 	static ScriptResult success(const QString& data) { return ScriptResult(data, true); }
 
-	const QString& data() const { return resultData; }
+	// Typed results, table cells hold QString or double
+	static ScriptResult fromBytes(const QByteArray& data);
+	static ScriptResult fromTable(const QStringList& columns, const QList<QVariantList>& rows);
+	static ScriptResult fromNumbers(const QVector<double>& values);
+
+	// Text of result, typed payload is rendered in its default format
+	QString data() const { return resultType == TypeText ? resultData : render(FormatText); }
 	bool isValid() const { return isResultValid; }
 
+	// Result was loaded from result cache instead of running the script
+	bool isFromCache() const { return isResultFromCache; }
+	void setFromCache(bool isCached) { isResultFromCache = isCached; }
+	Type type() const { return resultType; }
+
+	const QByteArray& bytes() const { return byteData; }
+	const QStringList& columns() const { return tableColumns; }
+	const QList<QVariantList>& rows() const { return tableRows; }
+	const QVector<double>& numbers() const { return numberData; }
+
+	// Format with name text, hex, csv or json, returns false for other names
+	static bool formatFromName(const QString& name, Format* format);
+
+	// Formats not applicable to the type fall back to text
+	QString render(Format format) const;
+
+	// JSON value of result, text becomes JSON string
+	QJsonValue toJson() const;
+
+	// Content written to files, bytes stay raw and other types are UTF-8 text
+	QByteArray rawData() const { return resultType == TypeBytes ? byteData : data().toUtf8(); }
+
+	// Payload of result, cache flag is not stored
+	friend QDataStream& operator<<(QDataStream& stream, const ScriptResult& result);
+	friend QDataStream& operator>>(QDataStream& stream, ScriptResult& result);
+
 private:
-	ScriptResult(const QString& value, bool isValueValid) : resultData(value), isResultValid(isValueValid) {}
+	ScriptResult(const QString& value, bool isValueValid) : resultData(value), resultType(TypeText), isResultValid(isValueValid), isResultFromCache(false) {}
+
+	QString renderCsv() const;
 
 private:
 	QString resultData;
+	QByteArray byteData;
+	QStringList tableColumns;
+	QList<QVariantList> tableRows;
+	QVector<double> numberData;
+	Type resultType;
 	bool isResultValid;
+	bool isResultFromCache;
 };
 
-#endif // SCRIPTRESULT_H
+Q_DECLARE_METATYPE(ScriptResult)
 
+#endif // SCRIPTRESULT_H
@@ -0,0 +1,187 @@
+#include "SharedData.h"
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include "Utility.h"
+
+using namespace v8;
+
+// Shorter texts are cheaper to copy than to track as external strings
+static const int ExternalTextLength = 4096;
+
+// Published buffer, never modified after it is created
+struct Block
+{
+	Block(const QByteArray& bytes) : data(bytes), isAscii(true), viewCount(0)
+	{
+		for (int i = 0; i < data.size() && isAscii; i++)
+			isAscii = (data.at(i) & 0x80) == 0;
+	}
+
+	QByteArray data;
+	bool isAscii;
+	QAtomicInt viewCount;
+};
+
+typedef QSharedPointer<Block> BlockPointer;
+
+// ArrayBuffer of one isolate pointing into block
+struct View
+{
+	View(Isolate* viewIsolate, const BlockPointer& viewBlock) : isolate(viewIsolate), block(viewBlock) { block->viewCount.ref(); }
+	~View() { block->viewCount.deref(); }
+
+	Isolate* isolate;
+	BlockPointer block;
+	Global<ArrayBuffer> buffer;
+};
+
+// Resource holds block until V8 releases the string
+class TextResource : public String::ExternalOneByteStringResource
+{
+public:
+	TextResource(const BlockPointer& textBlock) : block(textBlock) { block->viewCount.ref(); }
+	~TextResource() { block->viewCount.deref(); }
+
+	virtual const char* data() const { return block->data.constData(); }
+	virtual size_t length() const { return block->data.size(); }
+
+private:
+	BlockPointer block;
+};
+
+// V8 is never called with mutex locked, garbage collection may release views
+static QMutex sharedMutex;
+static QMap<QString, BlockPointer> blocks;
+static QList<View*> views;
+
+static BlockPointer findBlock(const QString& name)
+{
+	QMutexLocker locker(&sharedMutex);
+	return blocks.value(name);
+}
+
+static void viewCollected(const WeakCallbackInfo<View>& info)
+{
+	View* view = info.GetParameter();
+	view->buffer.Reset();
+	{
+		QMutexLocker locker(&sharedMutex);
+		views.removeOne(view);
+	}
+	delete view;
+}
+
+
+void SharedData::publish(const QString& name, const QByteArray& data)
+{
+	BlockPointer block(new Block(data));
+
+	QMutexLocker locker(&sharedMutex);
+	blocks.insert(name, block);
+}
+
+bool SharedData::publishFile(const QString& name, const QString& filePath, QString* errorMessage)
+{
+	QFile file(filePath);
+	if (!file.open(QFile::ReadOnly)) {
+		*errorMessage = QString("Could not open file: %1").arg(filePath);
+		return false;
+	}
+
+	publish(name, file.readAll());
+	return true;
+}
+
+bool SharedData::remove(const QString& name)
+{
+	QMutexLocker locker(&sharedMutex);
+	return blocks.remove(name) > 0;
+}
+
+QList<SharedData::Item> SharedData::items()
+{
+	QMutexLocker locker(&sharedMutex);
+
+	QList<Item> list;
+	for (QMap<QString, BlockPointer>::const_iterator it = blocks.constBegin(); it != blocks.constEnd(); ++it) {
+		Item item;
+		item.name = it.key();
+		item.size = it.value()->data.size();
+		item.viewCount = it.value()->viewCount.load();
+		list.append(item);
+	}
+	return list;
+}
+
+Local<ArrayBuffer> SharedData::arrayBuffer(Isolate* isolate, const QString& name)
+{
+	EscapableHandleScope handle_scope(isolate);
+	BlockPointer block = findBlock(name);
+	if (block.isNull())
+		return Local<ArrayBuffer>();
+
+	// Views of isolate are released only on its own thread, found view stays valid
+	View* existingView = NULL;
+	{
+		QMutexLocker locker(&sharedMutex);
+		for (int i = 0; i < views.count() && existingView == NULL; i++) {
+			if (views.at(i)->isolate == isolate && views.at(i)->block == block)
+				existingView = views.at(i);
+		}
+	}
+	if (existingView != NULL)
+		return handle_scope.Escape(Local<ArrayBuffer>::New(isolate, existingView->buffer));
+
+	// V8 doesn't free externalized memory, view keeps block alive until buffer is collected
+	Local<ArrayBuffer> buffer = ArrayBuffer::New(isolate, const_cast<char*>(block->data.constData()), block->data.size(), ArrayBufferCreationMode::kExternalized);
+	View* view = new View(isolate, block);
+	view->buffer.Reset(isolate, buffer);
+	view->buffer.SetWeak(view, viewCollected, WeakCallbackType::kParameter);
+	{
+		QMutexLocker locker(&sharedMutex);
+		views.append(view);
+	}
+
+	return handle_scope.Escape(buffer);
+}
+
+Local<String> SharedData::text(Isolate* isolate, const QString& name)
+{
+	EscapableHandleScope handle_scope(isolate);
+	BlockPointer block = findBlock(name);
+	if (block.isNull())
+		return Local<String>();
+
+	// Only ASCII reads the same as one byte string and UTF-8
+	if (!block->isAscii || block->data.size() < ExternalTextLength)
+		return handle_scope.Escape(Utility::toV8String(isolate, QString::fromUtf8(block->data)));
+
+	// V8 owns resource only when string is created
+	TextResource* resource = new TextResource(block);
+	Local<String> value;
+	if (!String::NewExternalOneByte(isolate, resource).ToLocal(&value)) {
+		delete resource;
+		return Local<String>();
+	}
+	return handle_scope.Escape(value);
+}
+
+void SharedData::releaseViews(Isolate* isolate)
+{
+	QList<View*> isolateViews;
+	{
+		QMutexLocker locker(&sharedMutex);
+		for (int i = views.count() - 1; i >= 0; i--) {
+			if (views.at(i)->isolate == isolate)
+				isolateViews.append(views.takeAt(i));
+		}
+	}
+
+	for (int i = 0; i < isolateViews.count(); i++) {
+		isolateViews.at(i)->buffer.Reset();
+		delete isolateViews.at(i);
+	}
+}
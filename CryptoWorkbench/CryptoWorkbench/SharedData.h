@@ -0,0 +1,56 @@
+#ifndef SHAREDDATA_H
+#define SHAREDDATA_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include "include/v8.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Read-only data published once per process and mapped into every isolate.
+/// Isolates get externalized ArrayBuffers or external strings pointing to the
+/// published buffer, each view holds a reference so removed data lives until
+/// the last view is collected. Views must not be written to.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class SharedData
+{
+public:
+	struct Item
+	{
+		Item() : size(0), viewCount(0) {}
+
+		QString name;
+		qint64 size;
+		int viewCount;
+	};
+
+	// Publish copy of data under name, data published earlier under the same name is replaced
+	static void publish(const QString& name, const QByteArray& data);
+
+	// Publish content of file without passing it through javascript heap
+	static bool publishFile(const QString& name, const QString& filePath, QString* errorMessage);
+
+	// Drop data from store, existing views stay valid
+	static bool remove(const QString& name);
+
+	// Published data sorted by name
+	static QList<Item> items();
+
+	// ArrayBuffer over data published under name, the same buffer is returned while isolate keeps it
+	// Returns empty handle when nothing is published under name
+	static v8::Local<v8::ArrayBuffer> arrayBuffer(v8::Isolate* isolate, const QString& name);
+
+	// Data published under name decoded as UTF-8, ASCII data is not copied
+	// Returns empty handle when nothing is published under name
+	static v8::Local<v8::String> text(v8::Isolate* isolate, const QString& name);
+
+	// Release views of isolate, must be called before isolate is disposed
+	static void releaseViews(v8::Isolate* isolate);
+
+private:
+	SharedData() {}
+};
+
+#endif // SHAREDDATA_H
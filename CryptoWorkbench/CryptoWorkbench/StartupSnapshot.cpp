@@ -0,0 +1,73 @@
+#include "StartupSnapshot.h"
+#include <QFile>
+#include <QCryptographicHash>
+
+using namespace v8;
+
+
+StartupSnapshot::StartupSnapshot()
+{
+	startupData.data = NULL;
+	startupData.raw_size = 0;
+}
+
+StartupSnapshot::~StartupSnapshot()
+{
+	delete[] startupData.data;
+}
+
+bool StartupSnapshot::create(const QString& snapshotFilePath, const QString& coreLibraryCode, const QStringList& moduleNames)
+{
+	// Placeholders are created by plain assignment so they stay configurable
+	QString source;
+	for (int i = 0; i < moduleNames.count(); i++)
+		source.append(QString("%1 = {};\n").arg(moduleNames.at(i)));
+	source.append(coreLibraryCode);
+
+	QByteArray sourceData = source.toUtf8();
+	StartupData blob = V8::CreateSnapshotDataBlob(sourceData.constData());
+	if (blob.data == NULL)
+		return false;
+
+	QFile file(snapshotFilePath);
+	bool ok = file.open(QFile::WriteOnly | QFile::Truncate);
+	if (ok) {
+		file.write(buildKey(coreLibraryCode));
+		ok = (file.write(blob.data, blob.raw_size) == blob.raw_size);
+	}
+
+	delete[] blob.data;
+	return ok;
+}
+
+bool StartupSnapshot::load(const QString& snapshotFilePath, const QString& coreLibraryCode)
+{
+	QFile file(snapshotFilePath);
+	if (!file.open(QFile::ReadOnly))
+		return false;
+
+	QByteArray key = buildKey(coreLibraryCode);
+	QByteArray content = file.readAll();
+	if (!content.startsWith(key) || content.size() == key.size())
+		return false;
+
+	delete[] startupData.data;
+
+	int length = content.size() - key.size();
+	char* buffer = new char[length];
+	memcpy(buffer, content.constData() + key.size(), length);
+
+	startupData.data = buffer;
+	startupData.raw_size = length;
+	return true;
+}
+
+QByteArray StartupSnapshot::buildKey(const QString& coreLibraryCode)
+{
+	QByteArray key;
+	key.append(V8::GetVersion());
+	key.append('\n');
+	key.append(QCryptographicHash::hash(coreLibraryCode.toUtf8(), QCryptographicHash::Sha1).toHex());
+	key.append('\n');
+	return key;
+}
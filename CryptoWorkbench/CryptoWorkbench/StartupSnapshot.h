@@ -0,0 +1,44 @@
+#ifndef STARTUPSNAPSHOT_H
+#define STARTUPSNAPSHOT_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include "include/v8.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Workbench specific V8 startup snapshot with core library already evaluated.
+///
+/// Native modules can't be serialized, so the core library runs against plain
+/// placeholder objects named after the modules. WorkbenchEngine moves properties
+/// of the placeholders onto the native module objects when creating a context.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class StartupSnapshot
+{
+public:
+	StartupSnapshot();
+	~StartupSnapshot();
+
+	// Build snapshot blob and write it to file
+	// V8 must be initialized before calling this method
+	static bool create(const QString& snapshotFilePath, const QString& coreLibraryCode, const QStringList& moduleNames);
+
+	// Load snapshot built from provided core library
+	// Returns false when file is missing or was built from different core library or V8 version
+	bool load(const QString& snapshotFilePath, const QString& coreLibraryCode);
+
+	bool isLoaded() const { return startupData.data != NULL; }
+	v8::StartupData* data() { return isLoaded() ? &startupData : NULL; }
+
+private:
+	static QByteArray buildKey(const QString& coreLibraryCode);
+
+private:
+	v8::StartupData startupData;
+
+	Q_DISABLE_COPY(StartupSnapshot)
+};
+
+#endif // STARTUPSNAPSHOT_H
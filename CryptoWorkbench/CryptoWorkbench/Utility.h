@@ -13,6 +13,15 @@
 class Utility
 {
 public:
+	// Isolate data slots used by workbench
+	enum DataSlot
+	{
+		DataSlotEngine,
+		DataSlotByteArrayTemplate,
+		DataSlotPropertyNames,
+		DataSlotNativeStatistics,
+	};
+
 	enum ExceptionType
 	{
 		ExceptionInvalidArgumentCount,
@@ -0,0 +1,190 @@
+#include "ValueCache.h"
+#include <QFile>
+#include <QDir>
+#include <QDataStream>
+#include <QCryptographicHash>
+
+// Identifies spill files, changes whenever file layout changes
+static const quint32 SpillFileMagic = 0x43574331;
+
+
+static qint64 valueSize(const QString& key, const ValueCache::Value& value)
+{
+	return (key.size() + value.text.size()) * sizeof(QChar) + value.bytes.size();
+}
+
+ValueCache::ValueCache(qint64 memoryLimit, const QString& directory)
+	: useCounter(0)
+	, memorySize(0)
+	, memoryLimit(memoryLimit)
+	, spillDirectory(directory)
+	, hitCount(0)
+	, diskHitCount(0)
+	, missCount(0)
+{
+	if (!spillDirectory.isEmpty()) {
+		if (!spillDirectory.endsWith('/'))
+			spillDirectory.append('/');
+		QDir().mkpath(spillDirectory);
+	}
+}
+
+bool ValueCache::get(const QString& key, Value* value)
+{
+	QHash<QString, Entry>::iterator it = entries.find(key);
+	if (it != entries.end()) {
+		touch(key, &it.value());
+		*value = it.value().value;
+		hitCount++;
+		return true;
+	}
+
+	// Value dropped from memory or stored by earlier session
+	if (readSpillFile(key, value)) {
+		insert(key, *value);
+		diskHitCount++;
+		return true;
+	}
+
+	missCount++;
+	return false;
+}
+
+bool ValueCache::put(const QString& key, const Value& value)
+{
+	remove(key);
+
+	bool isSpilled = writeSpillFile(key, value);
+	if (valueSize(key, value) > memoryLimit)
+		return isSpilled;
+
+	insert(key, value);
+	return true;
+}
+
+bool ValueCache::contains(const QString& key) const
+{
+	return entries.contains(key) || (!spillDirectory.isEmpty() && QFile::exists(spillFilePath(key)));
+}
+
+void ValueCache::remove(const QString& key)
+{
+	QHash<QString, Entry>::iterator it = entries.find(key);
+	if (it != entries.end()) {
+		usage.remove(it.value().lastUse);
+		memorySize -= it.value().size;
+		entries.erase(it);
+	}
+
+	if (!spillDirectory.isEmpty())
+		QFile::remove(spillFilePath(key));
+}
+
+ValueCache::Statistics ValueCache::statistics() const
+{
+	Statistics result;
+	result.count = entries.count();
+	result.memorySize = memorySize;
+	result.memoryLimit = memoryLimit;
+	result.hitCount = hitCount;
+	result.diskHitCount = diskHitCount;
+	result.missCount = missCount;
+	return result;
+}
+
+void ValueCache::insert(const QString& key, const Value& value)
+{
+	qint64 size = valueSize(key, value);
+	if (size > memoryLimit)
+		return;
+
+	evict(size);
+
+	Entry entry;
+	entry.value = value;
+	entry.size = size;
+	entry.lastUse = ++useCounter;
+	entries.insert(key, entry);
+	usage.insert(entry.lastUse, key);
+	memorySize += size;
+}
+
+void ValueCache::touch(const QString& key, Entry* entry)
+{
+	usage.remove(entry->lastUse);
+	entry->lastUse = ++useCounter;
+	usage.insert(entry->lastUse, key);
+}
+
+void ValueCache::evict(qint64 requiredSize)
+{
+	// Values are already on disk when spill directory is set, dropping them is enough
+	while (!usage.isEmpty() && memorySize + requiredSize > memoryLimit) {
+		QString key = usage.first();
+		usage.erase(usage.begin());
+
+		QHash<QString, Entry>::iterator it = entries.find(key);
+		memorySize -= it.value().size;
+		entries.erase(it);
+	}
+}
+
+QString ValueCache::spillFilePath(const QString& key) const
+{
+	return spillDirectory + QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex() + ".value";
+}
+
+bool ValueCache::writeSpillFile(const QString& key, const Value& value) const
+{
+	if (spillDirectory.isEmpty())
+		return false;
+
+	QFile file(spillFilePath(key));
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+		return false;
+
+	QDataStream stream(&file);
+	stream << SpillFileMagic << key << qint32(value.type);
+	if (value.type == TypeBytes)
+		stream << value.bytes;
+	else
+		stream << value.text;
+
+	if (stream.status() != QDataStream::Ok) {
+		file.remove();
+		return false;
+	}
+	return true;
+}
+
+bool ValueCache::readSpillFile(const QString& key, Value* value) const
+{
+	if (spillDirectory.isEmpty())
+		return false;
+
+	QFile file(spillFilePath(key));
+	if (!file.open(QFile::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	quint32 magic;
+	QString fileKey;
+	qint32 type;
+	stream >> magic >> fileKey >> type;
+
+	// Hash collision or file written by other version
+	if (stream.status() != QDataStream::Ok || magic != SpillFileMagic || fileKey != key || type < TypeString || type > TypeJson)
+		return false;
+
+	Value result;
+	result.type = static_cast<Type>(type);
+	if (result.type == TypeBytes)
+		stream >> result.bytes;
+	else
+		stream >> result.text;
+	if (stream.status() != QDataStream::Ok)
+		return false;
+
+	*value = result;
+	return true;
+}
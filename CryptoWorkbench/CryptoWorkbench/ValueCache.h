@@ -0,0 +1,90 @@
+#ifndef VALUECACHE_H
+#define VALUECACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Key/value store living for the whole engine lifetime, independent of contexts.
+/// Memory is limited, least recently used values are dropped first. With spill
+/// directory every value is written also to disk and dropped values are read back.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class ValueCache
+{
+public:
+	enum Type
+	{
+		TypeString,
+		TypeBytes,
+		TypeJson,
+	};
+
+	struct Value
+	{
+		Value() : type(TypeString) {}
+
+		Type type;
+		// Text for string and JSON values, bytes for binary values
+		QString text;
+		QByteArray bytes;
+	};
+
+	struct Statistics
+	{
+		Statistics() : count(0), memorySize(0), memoryLimit(0), hitCount(0), diskHitCount(0), missCount(0) {}
+
+		int count;
+		qint64 memorySize;
+		qint64 memoryLimit;
+		quint64 hitCount;
+		quint64 diskHitCount;
+		quint64 missCount;
+	};
+
+	// Limit is in bytes, empty directory keeps values only in memory
+	ValueCache(qint64 memoryLimit, const QString& directory);
+
+	bool get(const QString& key, Value* value);
+
+	// Returns false when value fits neither into memory nor into spill directory
+	bool put(const QString& key, const Value& value);
+
+	bool contains(const QString& key) const;
+
+	void remove(const QString& key);
+
+	Statistics statistics() const;
+
+private:
+	struct Entry
+	{
+		Value value;
+		qint64 size;
+		quint64 lastUse;
+	};
+
+	void insert(const QString& key, const Value& value);
+	void touch(const QString& key, Entry* entry);
+	void evict(qint64 requiredSize);
+	QString spillFilePath(const QString& key) const;
+	bool writeSpillFile(const QString& key, const Value& value) const;
+	bool readSpillFile(const QString& key, Value* value) const;
+
+	QHash<QString, Entry> entries;
+	QMap<quint64, QString> usage;
+	quint64 useCounter;
+	qint64 memorySize;
+	qint64 memoryLimit;
+	QString spillDirectory;
+	quint64 hitCount;
+	quint64 diskHitCount;
+	quint64 missCount;
+
+	Q_DISABLE_COPY(ValueCache)
+};
+
+#endif // VALUECACHE_H
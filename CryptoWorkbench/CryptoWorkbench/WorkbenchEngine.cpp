@@ -1,89 +1,566 @@
 #include "WorkbenchEngine.h"
 #include "include/libplatform/libplatform.h"
+#include "include/v8-profiler.h"
 #include <QFile>
+#include <QDir>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QRegularExpression>
 #include "ModuleTools.h"
 #include "ModuleByteArray.h"
+#include "ModuleParallel.h"
+#include "ModuleStats.h"
+#include "ModuleBench.h"
+#include "ModuleOutput.h"
+#include "ModuleCache.h"
+#include "ModuleShared.h"
+#include "NativeBinding.h"
+#include "NativeStatistics.h"
+#include "AsyncTasks.h"
+#include "WorkerPool.h"
+#include "CodeCache.h"
+#include "ValueCache.h"
+#include "ResultCache.h"
+#include "SharedData.h"
+#include "StartupSnapshot.h"
 #include "Utility.h"
 
 using namespace v8;
 
 void loadCallback(const FunctionCallbackInfo<Value>& args);
 void readFileCallback(const FunctionCallbackInfo<Value>& args);
-MaybeLocal<Value> executeString(WorkbenchEngine* workbenchEngine, Isolate* isolate, Local<String> source, Local<Value> name);
+void readFileAsyncCallback(const FunctionCallbackInfo<Value>& args);
+void preventCachingCallback(const FunctionCallbackInfo<Value>& args);
+MaybeLocal<Value> executeString(WorkbenchEngine* workbenchEngine, Isolate* isolate, Local<String> source, Local<Value> name, const CodeCache* codeCache = NULL, int lineOffset = 0);
+MaybeLocal<UnboundScript> compileScript(WorkbenchEngine* workbenchEngine, Isolate* isolate, Local<String> source, Local<Value> name, const CodeCache* codeCache, int lineOffset = 0);
+void heapLimitCallback(Isolate* isolate, GCType type, GCCallbackFlags flags);
 
+// Script is stopped when heap usage after garbage collection crosses configured limit,
+// V8 hard limit is set higher so the isolate survives until termination takes effect
+static const int HeapLimitHeadroom = 4;
 
-class WorkbenchEngine::ArrayBufferAllocator : public ArrayBuffer::Allocator
+// V8 default old space of 32-bit build is 700 MB, larger limit only makes address space exhaustion more likely
+static const int MaxHeapSize32 = 512;
+
+// Sampling interval of CPU profiler in microseconds
+static const int ProfilerSamplingInterval = 100;
+
+// Output buffer is flushed when it holds this many characters or its oldest chunk waits this many ms
+static const int OutputFlushSize = 64 * 1024;
+static const qint64 OutputFlushInterval = 100;
+
+// Objects registered by registerModules(), used as placeholders when building startup snapshot
+static const char* moduleNames[] = { "File", "Tools", "ByteArray", "Parallel", "Stats", "Bench", "Output", "Cache", "Shared" };
+
+// Wraps sources of values differing between runs, result of run using them is not cached.
+// Only argumentless Date() and new Date() read the clock, other forms are passed to the original constructor.
+static const char* nondeterministicWrapper =
+	"(function (preventCaching) {\n"
+	"	var nativeRandom = Math.random;\n"
+	"	var nativeNow = Date.now;\n"
+	"	var NativeDate = Date;\n"
+	"	var bind = Function.prototype.bind;\n"
+	"	Math.random = function random() { preventCaching(); return nativeRandom(); };\n"
+	"	var WrappedDate = function Date(year, month, date, hours, minutes, seconds, ms) {\n"
+	"		if (!(this instanceof Date)) { preventCaching(); return NativeDate(); }\n"
+	"		if (arguments.length === 0) preventCaching();\n"
+	"		var args = [null];\n"
+	"		for (var i = 0; i < arguments.length; i++) args[i + 1] = arguments[i];\n"
+	"		return new (bind.apply(NativeDate, args))();\n"
+	"	};\n"
+	"	WrappedDate.prototype = NativeDate.prototype;\n"
+	"	WrappedDate.prototype.constructor = WrappedDate;\n"
+	"	WrappedDate.now = function now() { preventCaching(); return nativeNow(); };\n"
+	"	WrappedDate.parse = NativeDate.parse;\n"
+	"	WrappedDate.UTC = NativeDate.UTC;\n"
+	"	this.Date = WrappedDate;\n"
+	"})";
+
+Platform* WorkbenchEngine::platform = NULL;
+
+
+class WorkbenchEngine::Watchdog : public QThread
 {
 public:
-	virtual void* Allocate(size_t length)
+	Watchdog(WorkbenchEngine* workbenchEngine, int timeout)
+		: engine(workbenchEngine), timeLimit(timeout), isCancelled(false)
 	{
-		void* data = AllocateUninitialized(length);
-		return data == NULL ? data : memset(data, 0, length);
+		if (timeLimit > 0)
+			start();
 	}
-	virtual void* AllocateUninitialized(size_t length) { return malloc(length); }
-	virtual void Free(void* data, size_t) { free(data); }
+
+	~Watchdog()
+	{
+		mutex.lock();
+		isCancelled = true;
+		condition.wakeAll();
+		mutex.unlock();
+		wait();
+	}
+
+protected:
+	virtual void run()
+	{
+		QElapsedTimer timer;
+		timer.start();
+
+		QMutexLocker locker(&mutex);
+		while (!isCancelled) {
+			qint64 remaining = timeLimit - timer.elapsed();
+			if (remaining <= 0) {
+				engine->terminate(TerminationTimeout);
+				return;
+			}
+			condition.wait(&mutex, remaining);
+		}
+	}
+
+private:
+	WorkbenchEngine* engine;
+	int timeLimit;
+	bool isCancelled;
+	QMutex mutex;
+	QWaitCondition condition;
 };
 
 
+// Script loaded by load(), compiled once per engine lifetime and run once per evaluation
+struct WorkbenchEngine::LoadedModule
+{
+	LoadedModule() : lastModified(0), size(0), generation(-1), isRunning(false), hasLexicalDeclarations(false) {}
+
+	qint64 lastModified;
+	qint64 size;
+	int generation;
+	bool isRunning;
+	bool hasLexicalDeclarations;
+	Global<UnboundScript> script;
+	Global<Value> exports;
+};
+
+
+// Writes serialized heap snapshot into file
+class HeapFileStream : public OutputStream
+{
+public:
+	HeapFileStream(QFile* outputFile) : file(outputFile), isFinished(false), isFailed(false) {}
+
+	virtual void EndOfStream() { isFinished = true; }
+	virtual int GetChunkSize() { return 64 * 1024; }
+
+	virtual WriteResult WriteAsciiChunk(char* data, int size)
+	{
+		if (file->write(data, size) != size) {
+			isFailed = true;
+			return kAbort;
+		}
+		return kContinue;
+	}
+
+	bool isComplete() const { return isFinished && !isFailed; }
+
+private:
+	QFile* file;
+	bool isFinished;
+	bool isFailed;
+};
+
+
+// Top-level let, const and class live outside global object, any of these words keeps context from being reused
+static bool hasLexicalDeclarations(const QString& source)
+{
+	QRegularExpression declaration("\\b(let|const|class)\\b");
+	return declaration.match(source).hasMatch();
+}
+
+// Names of own properties including non-enumerable ones, built-ins are not enumerable
+static MaybeLocal<Array> ownNames(Local<Context> context, Local<Function> ownPropertyNames, Local<Object> object)
+{
+	Local<Value> argument = object;
+	Local<Value> names;
+	if (!ownPropertyNames->Call(context, Undefined(context->GetIsolate()), 1, &argument).ToLocal(&names) || !names->IsArray())
+		return MaybeLocal<Array>();
+	return Local<Array>::Cast(names);
+}
+
+// Field of property descriptor, inherited properties are ignored
+static Local<Value> descriptorField(Local<Context> context, Local<Object> descriptor, NativeBinding::PropertyName field)
+{
+	Local<String> name = NativeBinding::name(context->GetIsolate(), field);
+	Local<Value> value;
+	if (!descriptor->HasOwnProperty(context, name).FromMaybe(false) || !descriptor->Get(context, name).ToLocal(&value))
+		return Undefined(context->GetIsolate());
+	return value;
+}
+
+// Append object with names and descriptors of its own properties to list of shared objects
+static bool watchObject(Local<Context> context, Local<Function> ownPropertyNames, Local<Object> object, Local<Array> watched, Local<Array>* names, Local<Array>* descriptors)
+{
+	if (!ownNames(context, ownPropertyNames, object).ToLocal(names))
+		return false;
+
+	*descriptors = Array::New(context->GetIsolate(), (*names)->Length());
+	for (uint32_t i = 0; i < (*names)->Length(); i++) {
+		Local<Value> descriptor;
+		if (!object->GetOwnPropertyDescriptor(context, Local<String>::Cast((*names)->Get(context, i).ToLocalChecked())).ToLocal(&descriptor) ||
+			!(*descriptors)->Set(context, i, descriptor).FromMaybe(false))
+			return false;
+	}
+
+	uint32_t index = watched->Length();
+	return watched->Set(context, index, object).FromMaybe(false) &&
+		   watched->Set(context, index + 1, *names).FromMaybe(false) &&
+		   watched->Set(context, index + 2, *descriptors).FromMaybe(false);
+}
+
+// Compare own properties of object with names and descriptors remembered by watchObject()
+static bool isObjectUnchanged(Local<Context> context, Local<Function> ownPropertyNames, Local<Object> object, Local<Array> names, Local<Array> descriptors)
+{
+	static const NativeBinding::PropertyName fields[] = { NativeBinding::NameValue, NativeBinding::NameGet, NativeBinding::NameSet, NativeBinding::NameWritable };
+
+	Local<Array> currentNames;
+	if (!ownNames(context, ownPropertyNames, object).ToLocal(&currentNames) || currentNames->Length() != names->Length())
+		return false;
+
+	for (uint32_t i = 0; i < names->Length(); i++) {
+		Local<Value> name = names->Get(context, i).ToLocalChecked();
+		Local<Value> current;
+		if (!name->StrictEquals(currentNames->Get(context, i).ToLocalChecked()) ||
+			!object->GetOwnPropertyDescriptor(context, Local<String>::Cast(name)).ToLocal(&current) || !current->IsObject())
+			return false;
+
+		Local<Object> descriptor = Local<Object>::Cast(descriptors->Get(context, i).ToLocalChecked());
+		for (size_t j = 0; j < sizeof(fields) / sizeof(fields[0]); j++) {
+			if (!descriptorField(context, descriptor, fields[j])->SameValue(descriptorField(context, Local<Object>::Cast(current), fields[j])))
+				return false;
+		}
+	}
+	return true;
+}
+
+
 WorkbenchEngine::WorkbenchEngine(const Environment& engineEnvironment)
-	: environment(engineEnvironment)
+	: environment(engineEnvironment), startupSnapshot(new StartupSnapshot()), terminationReason(TerminationNone), heapLimit(0), peakHeapSize(0), runGeneration(0), isPersistentContextDirty(false),
+	  outputSink(NULL), outputFile(NULL), isOutputWritten(false), cache(NULL), nativeCounters(NULL),
+	  resultCache(NULL), isResultCacheBypassed(engineEnvironment.resultCacheBypassed), isRunCacheable(true)
 {
-	// Initialize V8.
-	V8::InitializeICU();
-	platform = v8::platform::CreateDefaultPlatform();
-	V8::InitializePlatform(platform);
-	V8::Initialize();
+	initializeV8(environment.v8DataPath);
+
+	// Load core library
+	QFile file(environment.coreLibraryPath + environment.coreLibraryName);
+	if (file.open(QFile::ReadOnly))
+		coreLibraryCode = QString::fromUtf8(file.readAll());
 
-#ifdef QT_NO_DEBUG
-	V8::InitializeExternalStartupData("..\\bin\\natives_blob.bin", "..\\bin\\snapshot_blob.bin");
-#else
-	V8::InitializeExternalStartupData("..\\bin_debug\\natives_blob.bin", "..\\bin_debug\\snapshot_blob.bin");
-#endif
+	// Load snapshot with core library already evaluated, falls back to default V8 snapshot
+	if (!environment.startupSnapshotPath.isEmpty())
+		startupSnapshot->load(environment.startupSnapshotPath, coreLibraryCode);
 
-	alocator = new ArrayBufferAllocator();
+	alocator = new BufferAllocator();
 
 	// Create a new Isolate and make it the current one.
 	Isolate::CreateParams create_params;
 	create_params.array_buffer_allocator = alocator;
+	create_params.snapshot_blob = startupSnapshot->data();
+	if (sizeof(void*) == 4 && environment.maxHeapSize > MaxHeapSize32)
+		environment.maxHeapSize = MaxHeapSize32;
+	if (environment.maxHeapSize > 0) {
+		heapLimit = static_cast<size_t>(environment.maxHeapSize) * 1024 * 1024;
+		create_params.constraints.set_max_old_space_size(environment.maxHeapSize + environment.maxHeapSize / HeapLimitHeadroom);
+	}
 	isolate = Isolate::New(create_params);
 
-	// Load core library
-	QFile file(environment.coreLibraryPath + environment.coreLibraryName);
-	if (file.open(QFile::ReadOnly))
-		coreLibraryCode = QString::fromUtf8(file.readAll());
+	isolate->SetData(Utility::DataSlotEngine, this);
+	isolate->AddGCEpilogueCallback(heapLimitCallback);
+
+	if (environment.nativeStatistics)
+		setNativeStatisticsEnabled(true);
+
+	if (!environment.resultCacheDirectory.isEmpty())
+		resultCache = new ResultCache(environment.resultCacheDirectory, qint64(environment.maxResultCacheSize) * 1024 * 1024);
 }
 
 WorkbenchEngine::~WorkbenchEngine()
 {
-	// Dispose the isolate and tear down V8.
+	delete workers.load();
+
+	{
+		Locker locker(isolate);
+		delete tasks.load();
+		reset();
+		workspaceString.reset();
+		SharedData::releaseViews(isolate);
+		qDeleteAll(loadedModules);
+		loadedModules.clear();
+		ModuleByteArray::disposeTemplates(isolate);
+		NativeBinding::disposeNames(isolate);
+	}
+
+	// Dispose the isolate, V8 itself is torn down by disposeV8()
 	isolate->Dispose();
+	delete alocator;
+	delete startupSnapshot;
+	delete cache;
+	delete nativeCounters;
+	qDeleteAll(retiredCounters);
+	delete resultCache;
+}
+
+void WorkbenchEngine::initializeV8(const QString& v8DataPath)
+{
+	if (platform != NULL)
+		return;
+
+	// Initialize V8.
+	V8::InitializeICU();
+	platform = v8::platform::CreateDefaultPlatform();
+	V8::InitializePlatform(platform);
+	V8::Initialize();
+
+	if (!v8DataPath.isEmpty()) {
+		QByteArray nativesPath = QFile::encodeName(v8DataPath + "natives_blob.bin");
+		QByteArray snapshotPath = QFile::encodeName(v8DataPath + "snapshot_blob.bin");
+		V8::InitializeExternalStartupData(nativesPath.constData(), snapshotPath.constData());
+	}
+}
+
+void WorkbenchEngine::disposeV8()
+{
+	if (platform == NULL)
+		return;
+
+	// Tear down V8.
 	V8::Dispose();
 	V8::ShutdownPlatform();
 	delete platform;
-	delete alocator;
+	platform = NULL;
 }
 
-ScriptResult WorkbenchEngine::evaluate(const QString& scriptText, const QString& workspaceText)
+bool WorkbenchEngine::createStartupSnapshot(const Environment& environment)
 {
-	exceptions.clear();
+	initializeV8(environment.v8DataPath);
+
+	QFile file(environment.coreLibraryPath + environment.coreLibraryName);
+	if (!file.open(QFile::ReadOnly))
+		return false;
+
+	QStringList names;
+	for (size_t i = 0; i < sizeof(moduleNames) / sizeof(moduleNames[0]); i++)
+		names.append(moduleNames[i]);
+
+	return StartupSnapshot::create(environment.startupSnapshotPath, QString::fromUtf8(file.readAll()), names);
+}
+
+ScriptResult WorkbenchEngine::evaluate(const QString& scriptText, const QString& workspaceText, ScriptProfile* profile)
+{
+	// Engine may be used from different threads, each run takes the isolate for itself
+	Locker locker(isolate);
+	Isolate::Scope isolate_scope(isolate);
+
+	// Identical run over unchanged files returns stored result without running, profiled runs always run
+	QByteArray cacheKey;
+	if (resultCache != NULL && profile == NULL) {
+		cacheKey = resultCacheKey(scriptText, workspaceText);
+		ScriptResult cachedResult;
+		if (!isResultCacheBypassed && resultCache->find(cacheKey, &cachedResult)) {
+			// Nothing is left running for stop meant for this run
+			cancelPendingStop();
+			heapBefore = heapUsage();
+			heapAfter = heapBefore;
+			return cachedResult;
+		}
+	}
+
+	if (!beginRun())
+		return finishRun(ScriptResult::error(QString()));
+
+	HandleScope handle_scope(isolate);
+	Local<String> profileTitle = String::NewFromUtf8(isolate, "evaluate");
+	CpuProfiler* profiler = isolate->GetCpuProfiler();
+	if (profile != NULL) {
+		profiler->SetSamplingInterval(ProfilerSamplingInterval);
+		profiler->StartProfiling(profileTitle, true);
+	}
+
+	ScriptResult result;
+	{
+		Watchdog watchdog(this, environment.maxRunTime);
+		result = run(scriptText, workspaceText);
+	}
+
+	if (profile != NULL) {
+		CpuProfile* cpuProfile = profiler->StopProfiling(profileTitle);
+		*profile = cpuProfile != NULL ? ScriptProfile(cpuProfile) : ScriptProfile();
+		if (cpuProfile != NULL)
+			cpuProfile->Delete();
+	}
+
+	result = finishRun(result);
+
+	// Output streamed to sink would be lost on replay, failed runs may depend on time limits
+	if (!cacheKey.isEmpty() && result.isValid() && isRunCacheable && !(isOutputWritten && outputSink != NULL))
+		resultCache->store(cacheKey, readFiles, result);
+	return result;
+}
 
+ScriptResult WorkbenchEngine::evaluateCells(const QList<ScriptCell>& cells, const QString& workspaceText, QVector<qint64>* cellTimes)
+{
+	Locker locker(isolate);
 	Isolate::Scope isolate_scope(isolate);
+	if (!beginRun())
+		return finishRun(ScriptResult::error(QString()));
+
 	HandleScope handle_scope(isolate);
+	ScriptResult result;
+	{
+		Watchdog watchdog(this, environment.maxRunTime);
+		result = runCells(cells, workspaceText, cellTimes);
+	}
+	return finishRun(result);
+}
+
+// Returns false when stop was requested before the run started, script is not executed then
+bool WorkbenchEngine::beginRun()
+{
+	exceptions.clear();
+	runGeneration++;
+	isolate->CancelTerminateExecution();
+
+	HeapStatistics heapStatistics;
+	isolate->GetHeapStatistics(&heapStatistics);
+	peakHeapSize = heapStatistics.used_heap_size();
+	alocator->resetPeak();
+	heapBefore = heapUsage();
+
+	// No native of earlier run is still holding collectors disabled during it
+	qDeleteAll(retiredCounters);
+	retiredCounters.clear();
+	if (nativeCounters != NULL)
+		nativeCounters->clear();
+
+	AsyncTasks* asyncTasks = tasks.load();
+	if (asyncTasks != NULL)
+		asyncTasks->cancelPending();
 
-	Local<Context> context = createGlobalContext(workspaceText);
+	outputBuffer.clear();
+	collectedOutput.clear();
+	isOutputWritten = false;
+	outputTimer.start();
+
+	isRunCacheable = true;
+	readFiles.clear();
+
+	// Checked after termination was cancelled, later stop terminates the script normally
+	return terminationReason.load() == TerminationNone;
+}
+
+ScriptResult WorkbenchEngine::finishRun(ScriptResult result)
+{
+	// Output written before failure is still delivered
+	if (!finishOutput() && result.isValid())
+		result = ScriptResult::error("Could not write output");
+	else if (!collectedOutput.isEmpty() && result.isValid())
+		result = ScriptResult::success(collectedOutput + result.data());
+
+	heapAfter = heapUsage();
+
+	// Allow next run after script was stopped, stop arriving from now on is kept for the next run
+	TerminationReason reason = static_cast<TerminationReason>(terminationReason.fetchAndStoreOrdered(TerminationNone));
+	if (reason != TerminationNone) {
+		isolate->CancelTerminateExecution();
+		if (reason == TerminationHeapLimit)
+			isolate->LowMemoryNotification();
+		if (!result.isValid())
+			return terminationResult(reason);
+	}
+	return result;
+}
+
+QByteArray WorkbenchEngine::resultCacheKey(const QString& scriptText, const QString& workspaceText) const
+{
+	// Script name appears in error messages, load path decides which files are read
+	QStringList inputs;
+	inputs << coreLibraryCode << environment.currentScriptName << environment.workspaceName << environment.scriptLoadPath << scriptText << workspaceText;
+	return ResultCache::runKey(inputs);
+}
+
+void WorkbenchEngine::terminate(TerminationReason reason)
+{
+	// Keep the first reason, watchdog may fire while heap limit termination is in progress
+	if (terminationReason.testAndSetOrdered(TerminationNone, reason))
+		isolate->TerminateExecution();
+
+	// Script may be waiting for parallel workers
+	WorkerPool* workerPool = workers.load();
+	if (workerPool != NULL)
+		workerPool->terminate();
+
+	// Or for async natives
+	AsyncTasks* asyncTasks = tasks.load();
+	if (asyncTasks != NULL)
+		asyncTasks->interrupt();
+}
+
+void WorkbenchEngine::cancelPendingStop()
+{
+	terminationReason.testAndSetOrdered(TerminationStop, TerminationNone);
+}
+
+void WorkbenchEngine::checkHeapUsage()
+{
+	HeapStatistics heapStatistics;
+	isolate->GetHeapStatistics(&heapStatistics);
+	peakHeapSize = qMax(peakHeapSize, heapStatistics.used_heap_size());
+
+	if (heapLimit > 0 && heapStatistics.used_heap_size() > heapLimit)
+		terminate(TerminationHeapLimit);
+}
+
+ScriptResult WorkbenchEngine::terminationResult(TerminationReason reason) const
+{
+	QString peakUsage = QString("peak heap usage %1 MB").arg(peakHeapSize / (1024.0 * 1024.0), 0, 'f', 1);
+
+	switch (reason) {
+		case TerminationTimeout:
+			return ScriptResult::error(QString("Script exceeded time limit of %1 ms, %2").arg(environment.maxRunTime).arg(peakUsage));
+		case TerminationHeapLimit:
+			return ScriptResult::error(QString("Script exceeded heap limit of %1 MB, %2").arg(environment.maxHeapSize).arg(peakUsage));
+		default:
+			break;
+	}
+	return ScriptResult::error("Script execution stopped");
+}
+
+ScriptResult WorkbenchEngine::run(const QString& scriptText, const QString& workspaceText)
+{
+	HandleScope handle_scope(isolate);
+
+	// Reuse prepared context when running in persistent mode, context left with state that can't be undone is replaced
+	bool isContextPrepared = environment.persistentContext && !persistentContext.IsEmpty();
+
+	Local<Context> context;
+	if (isContextPrepared) {
+		context = Local<Context>::New(isolate, persistentContext);
+		Context::Scope restore_scope(context);
+		isContextPrepared = !isPersistentContextDirty && restoreGlobals(context, workspaceText);
+		if (!isContextPrepared)
+			releasePersistentContext();
+	}
+	if (!isContextPrepared)
+		context = createGlobalContext(workspaceText);
 	if (context.IsEmpty())
 		return ScriptResult::error("Error creating context");
 
 	Context::Scope context_scope(context);
 
-	// Compile and run core library if loaded
-	if (!coreLibraryCode.isEmpty()) {
-		MaybeLocal<Value> coreLibResult = executeString(this, isolate, 
-														Utility::toV8String(isolate, coreLibraryCode),
-														Utility::toV8String(isolate, environment.coreLibraryName));
-		if (coreLibResult.IsEmpty())
+	if (!isContextPrepared) {
+		if (!initializeContext(context) || (environment.persistentContext && !rememberGlobals(context)))
 			return ScriptResult::error(exceptions.join("\n\n"));
 	}
+	isPersistentContextDirty = hasLexicalDeclarations(scriptText);
 
 	// Compile and run the javascript
 	MaybeLocal<Value> result = executeString(this, isolate, 
@@ -92,19 +569,251 @@ ScriptResult WorkbenchEngine::evaluate(const QString& scriptText, const QString&
 	if (result.IsEmpty())
 		return ScriptResult::error(exceptions.join("\n\n"));
 
+	return awaitResult(context, result.ToLocalChecked(), workspaceText);
+}
+
+ScriptResult WorkbenchEngine::runCells(const QList<ScriptCell>& cells, const QString& workspaceText, QVector<qint64>* cellTimes)
+{
+	HandleScope handle_scope(isolate);
+
+	// Leading cells matching the last run are skipped, their state lives in cell context.
+	// Changed workspace input runs all cells again so the cells see the new text.
+	int firstCell = 0;
+	if (!cellContext.IsEmpty() && workspaceText == cellWorkspaceText) {
+		while (firstCell < cells.count() && firstCell < cellSources.count() && cells.at(firstCell).code == cellSources.at(firstCell))
+			firstCell++;
+
+		// Unchanged script reruns its last cell
+		if (firstCell == cells.count())
+			firstCell = qMax(0, cells.count() - 1);
+	}
+
+	Local<Context> context;
+	if (firstCell > 0)
+		context = Local<Context>::New(isolate, cellContext);
+	else
+		context = createGlobalContext(workspaceText);
+	if (context.IsEmpty())
+		return ScriptResult::error("Error creating context");
+
+	Context::Scope context_scope(context);
+
+	// Workspace keeps value left by earlier cells when they are skipped
+	QString currentWorkspace = workspaceText;
+	if (firstCell == 0) {
+		cellContext.Reset();
+		cellSources.clear();
+		if (!initializeContext(context))
+			return ScriptResult::error(exceptions.join("\n\n"));
+		cellContext.Reset(isolate, context);
+		cellWorkspaceText = workspaceText;
+	}
+	else {
+		Local<Value> workspaceValue;
+		if (context->Global()->Get(context, Utility::toV8String(isolate, environment.workspaceName)).ToLocal(&workspaceValue) && workspaceValue->IsString())
+			currentWorkspace = workspaceString.isCurrent(isolate, workspaceValue) ? workspaceString.text() : Utility::toString(workspaceValue);
+	}
+
+	// Failed cell and everything after it runs again next time
+	cellSources = cellSources.mid(0, firstCell);
+	cellTimes->fill(-1, cells.count());
+
+	Local<Value> result = Undefined(isolate);
+	for (int i = firstCell; i < cells.count(); i++) {
+		QElapsedTimer timer;
+		timer.start();
+		MaybeLocal<Value> cellResult = executeString(this, isolate,
+													 Utility::toV8String(isolate, cells.at(i).code),
+													 Utility::toV8String(isolate, environment.currentScriptName),
+													 NULL, cells.at(i).line);
+		(*cellTimes)[i] = timer.elapsed();
+
+		if (!cellResult.ToLocal(&result))
+			return ScriptResult::error(exceptions.join("\n\n"));
+		cellSources.append(cells.at(i).code);
+	}
+
+	return awaitResult(context, result, currentWorkspace);
+}
+
+ScriptResult WorkbenchEngine::awaitResult(Local<Context> context, Local<Value> result, const QString& workspaceText)
+{
+	HandleScope handle_scope(isolate);
+
+	// Promises of async natives are settled before workspace is read, promise returned by script is replaced with its value
+	QString errorMessage;
+	if (!asyncTasks()->await(isolate, &result, &errorMessage)) {
+		exceptions.append(errorMessage);
+		return ScriptResult::error(exceptions.join("\n\n"));
+	}
+
+	return workspaceResult(context, result, workspaceText);
+}
+
+ScriptResult WorkbenchEngine::workspaceResult(Local<Context> context, Local<Value> result, const QString& workspaceText)
+{
+	HandleScope handle_scope(isolate);
+
 	// Get output variable.
-	MaybeLocal<Value> outputValue = context->Global()->Get(Utility::toV8String(isolate, environment.workspaceName));
-	if (outputValue.IsEmpty())
+	Local<Value> outputValue;
+	if (!context->Global()->Get(context, Utility::toV8String(isolate, environment.workspaceName)).ToLocal(&outputValue))
 		return ScriptResult::error("Workspace error");
 
-	QString resultString = Utility::toString(result.ToLocalChecked());
-	QString outputString = Utility::toString(outputValue.ToLocalChecked());
+	// Workspace holding ByteArray, array or object is returned as typed result
+	if (!outputValue->IsString()) {
+		if (outputValue->IsUndefined() || outputValue->IsNull())
+			return createResult(context, result);
+		return createResult(context, outputValue);
+	}
+
+	// Workspace left untouched is returned without converting it back from V8
+	QString outputString = workspaceString.isCurrent(isolate, outputValue) ? workspaceString.text() : Utility::toString(outputValue);
+
+	// Workspace is optional for scripts streaming through Output, unchanged input is not echoed
+	if (isOutputWritten && outputString == workspaceText)
+		return ScriptResult::success(QString());
 
 	if (outputString.isEmpty())
-		return ScriptResult::success(resultString);
+		return createResult(context, result);
 	return ScriptResult::success(outputString);
 }
 
+// Object literal or Object.create(null), not RegExp, Error, Date, boxed primitive or instance of user class
+static bool isPlainObject(Isolate* isolate, Local<Value> value)
+{
+	if (!value->IsObject() || value->IsFunction())
+		return false;
+
+	// Prototype of new object is Object.prototype of current context even when script replaced global Object
+	Local<Value> prototype = Local<Object>::Cast(value)->GetPrototype();
+	return prototype->IsNull() || prototype->StrictEquals(Object::New(isolate)->GetPrototype());
+}
+
+ScriptResult WorkbenchEngine::createResult(Local<Context> context, Local<Value> value)
+{
+	HandleScope handle_scope(isolate);
+
+	if (!value->IsObject() || value->IsStringObject())
+		return ScriptResult::success(Utility::toString(value));
+
+	// Binary data is passed without string conversion
+	if (ModuleByteArray::isByteArray(isolate, value))
+		return ScriptResult::fromBytes(ModuleByteArray::unwrapByteArray(isolate, Local<Object>::Cast(value)));
+	if (value->IsArrayBuffer())
+		return ScriptResult::fromBytes(Utility::toByteArray(value));
+	if (value->IsUint8Array() || value->IsInt8Array() || value->IsUint8ClampedArray()) {
+		Local<ArrayBufferView> view = Local<ArrayBufferView>::Cast(value);
+		ArrayBuffer::Contents contents = view->Buffer()->GetContents();
+		return ScriptResult::fromBytes(QByteArray(static_cast<const char*>(contents.Data()) + view->ByteOffset(), static_cast<int>(view->ByteLength())));
+	}
+	if (value->IsFloat64Array()) {
+		Local<Float64Array> array = Local<Float64Array>::Cast(value);
+		QVector<double> values(static_cast<int>(array->Length()));
+		array->CopyContents(values.data(), array->ByteLength());
+		return ScriptResult::fromNumbers(values);
+	}
+
+	// Arrays of numbers and other typed arrays become numeric arrays
+	if (value->IsArray() || value->IsTypedArray()) {
+		Local<Object> array = Local<Object>::Cast(value);
+		uint32_t length = value->IsArray() ? Local<Array>::Cast(value)->Length() : static_cast<uint32_t>(Local<TypedArray>::Cast(value)->Length());
+
+		QVector<double> values;
+		values.reserve(length);
+		for (uint32_t i = 0; i < length; i++) {
+			Local<Value> item;
+			if (!array->Get(context, i).ToLocal(&item) || !item->IsNumber())
+				break;
+			values.append(item->NumberValue(context).FromJust());
+		}
+		if (length > 0 && values.size() == static_cast<int>(length))
+			return ScriptResult::fromNumbers(values);
+
+		// Arrays of rows or records become tables
+		QStringList columns;
+		QList<QVariantList> rows;
+		if (value->IsArray() && length > 0 && createTable(context, Local<Array>::Cast(value), &columns, &rows))
+			return ScriptResult::fromTable(columns, rows);
+	}
+	else if (isPlainObject(isolate, value)) {
+		// Plain object maps keys to values, e.g. frequency counts
+		Local<Object> object = Local<Object>::Cast(value);
+		Local<Array> names;
+		if (object->GetOwnPropertyNames(context).ToLocal(&names) && names->Length() > 0) {
+			QList<QVariantList> rows;
+			for (uint32_t i = 0; i < names->Length(); i++) {
+				Local<Value> name = names->Get(context, i).ToLocalChecked();
+				Local<Value> item;
+				if (!object->Get(context, name).ToLocal(&item) || item->IsObject())
+					break;
+
+				QVariantList row;
+				row << Utility::toString(name);
+				row << (item->IsNumber() ? QVariant(item->NumberValue(context).FromJust()) : QVariant(Utility::toString(item)));
+				rows.append(row);
+			}
+			if (rows.size() == static_cast<int>(names->Length()))
+				return ScriptResult::fromTable(QStringList() << "key" << "value", rows);
+		}
+	}
+
+	return ScriptResult::success(Utility::toString(value));
+}
+
+bool WorkbenchEngine::createTable(Local<Context> context, Local<Array> array, QStringList* columns, QList<QVariantList>* rows)
+{
+	HandleScope handle_scope(isolate);
+
+	// Column names come from the first record, rows given as arrays have no names
+	Local<Value> first;
+	if (!array->Get(context, 0).ToLocal(&first) || !first->IsObject())
+		return false;
+
+	Local<Array> names;
+	bool isRecord = !first->IsArray();
+	if (isRecord) {
+		if (!Local<Object>::Cast(first)->GetOwnPropertyNames(context).ToLocal(&names) || names->Length() == 0)
+			return false;
+		for (uint32_t i = 0; i < names->Length(); i++)
+			columns->append(Utility::toString(names->Get(context, i).ToLocalChecked()));
+	}
+
+	for (uint32_t i = 0; i < array->Length(); i++) {
+		Local<Value> item;
+		if (!array->Get(context, i).ToLocal(&item) || !item->IsObject() || item->IsArray() == isRecord)
+			return false;
+
+		Local<Object> object = Local<Object>::Cast(item);
+		uint32_t cellCount = isRecord ? names->Length() : Local<Array>::Cast(item)->Length();
+
+		QVariantList row;
+		for (uint32_t j = 0; j < cellCount; j++) {
+			Local<Value> cell;
+			bool isRead = isRecord ? object->Get(context, names->Get(context, j).ToLocalChecked()).ToLocal(&cell) : object->Get(context, j).ToLocal(&cell);
+			if (!isRead)
+				return false;
+			row << (cell->IsNumber() ? QVariant(cell->NumberValue(context).FromJust()) : QVariant(Utility::toString(cell)));
+		}
+		rows->append(row);
+	}
+	return true;
+}
+
+void WorkbenchEngine::reset()
+{
+	Locker locker(isolate);
+	releasePersistentContext();
+	cellContext.Reset();
+	cellSources.clear();
+	cellWorkspaceText.clear();
+
+	// Exports belong to dropped context, compiled code stays valid
+	foreach (LoadedModule* module, loadedModules) {
+		module->exports.Reset();
+		module->generation = -1;
+	}
+}
+
 QString WorkbenchEngine::resolveScriptFilePath(const QString& fileName)
 {
 	// TODO - Add proper sanitization and escaping
@@ -115,8 +824,269 @@ QString WorkbenchEngine::resolveScriptFilePath(const QString& fileName)
 	return resolvedPath;
 }
 
+BufferAllocator::Statistics WorkbenchEngine::allocatorStatistics() const
+{
+	return alocator->statistics();
+}
+
+HeapUsage WorkbenchEngine::heapUsage()
+{
+	HeapUsage usage;
+
+	HeapStatistics heapStatistics;
+	isolate->GetHeapStatistics(&heapStatistics);
+	usage.totalHeapSize = heapStatistics.total_heap_size();
+	usage.usedHeapSize = heapStatistics.used_heap_size();
+	usage.heapSizeLimit = heapStatistics.heap_size_limit();
+	usage.externalSize = alocator->statistics().liveBytes;
+	usage.peakUsedHeapSize = qMax(peakHeapSize, usage.usedHeapSize);
+	usage.peakExternalSize = alocator->statistics().peakBytes;
+
+	for (size_t i = 0; i < isolate->NumberOfHeapSpaces(); i++) {
+		HeapSpaceStatistics spaceStatistics;
+		if (!isolate->GetHeapSpaceStatistics(&spaceStatistics, i))
+			continue;
+
+		HeapUsage::Space space;
+		space.name = QString::fromLatin1(spaceStatistics.space_name());
+		space.size = spaceStatistics.space_size();
+		space.usedSize = spaceStatistics.space_used_size();
+		space.availableSize = spaceStatistics.space_available_size();
+		usage.spaces.append(space);
+	}
+	return usage;
+}
+
+bool WorkbenchEngine::writeHeapSnapshot(const QString& filePath)
+{
+	Locker locker(isolate);
+	Isolate::Scope isolate_scope(isolate);
+	HandleScope handle_scope(isolate);
+
+	QFile file(filePath);
+	if (!file.open(QFile::WriteOnly | QFile::Truncate))
+		return false;
+
+	HeapFileStream stream(&file);
+	const HeapSnapshot* snapshot = isolate->GetHeapProfiler()->TakeHeapSnapshot();
+	if (snapshot == NULL)
+		return false;
+
+	snapshot->Serialize(&stream, HeapSnapshot::kJSON);
+	const_cast<HeapSnapshot*>(snapshot)->Delete();
+	return stream.isComplete();
+}
+
+WorkerPool* WorkbenchEngine::workerPool()
+{
+	if (environment.workerCount < 0)
+		return NULL;
+
+	// Only the thread running script creates the pool, terminate() may read it from elsewhere
+	if (workers.load() == NULL) {
+		int workerCount = environment.workerCount > 0 ? environment.workerCount : QThread::idealThreadCount();
+		// Chunks of Parallel calls are not stored, run calling them is not stored either
+		Environment workerEnvironment = environment;
+		workerEnvironment.resultCacheDirectory.clear();
+		workers.store(new WorkerPool(workerEnvironment, workerCount));
+	}
+	return workers.load();
+}
+
+ValueCache* WorkbenchEngine::valueCache()
+{
+	// Values outlive contexts, cache is dropped only with the engine
+	if (cache == NULL)
+		cache = new ValueCache(qint64(environment.maxCacheSize) * 1024 * 1024, environment.cacheDirectory);
+	return cache;
+}
+
+AsyncTasks* WorkbenchEngine::asyncTasks()
+{
+	// Pointer is read by terminate() from other threads
+	if (tasks.load() == NULL)
+		tasks.store(new AsyncTasks(environment.asyncThreadCount));
+	return tasks.load();
+}
+
+void WorkbenchEngine::setNativeStatisticsEnabled(bool isEnabled)
+{
+	Locker locker(isolate);
+	if (isEnabled == (nativeCounters != NULL))
+		return;
+
+	// Natives find collector through isolate, empty slot disables collection
+	if (isEnabled) {
+		nativeCounters = new NativeStatistics();
+	}
+	else {
+		// Natives running below Stats.collectNatives still hold the collector, it is freed at start of next run
+		retiredCounters.append(nativeCounters);
+		nativeCounters = NULL;
+	}
+	isolate->SetData(Utility::DataSlotNativeStatistics, nativeCounters);
+}
+
+void WorkbenchEngine::addReadFile(const QString& filePath)
+{
+	if (!readFiles.contains(filePath))
+		readFiles.append(filePath);
+}
+
+MaybeLocal<Value> WorkbenchEngine::loadModule(const QString& filePath, Local<Value> name)
+{
+	EscapableHandleScope handle_scope(isolate);
+	addReadFile(filePath);
+
+	// Compiled code is dropped when file changes
+	QFileInfo fileInfo(filePath);
+	qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+	LoadedModule* module = loadedModules.value(filePath);
+	if (module != NULL && (module->lastModified != lastModified || module->size != fileInfo.size()) && !module->isRunning) {
+		delete loadedModules.take(filePath);
+		module = NULL;
+	}
+
+	if (module == NULL) {
+		QFile file(filePath);
+		if (!file.open(QFile::ReadOnly)) {
+			Utility::throwException(isolate, QString("Could not open file: %1").arg(filePath));
+			return MaybeLocal<Value>();
+		}
+
+		QByteArray fileContent = file.readAll();
+		Local<String> source;
+		if (!String::NewFromUtf8(isolate, fileContent.data(), NewStringType::kNormal, fileContent.length()).ToLocal(&source)) {
+			Utility::throwException(isolate, QString("File too large: %1").arg(filePath));
+			return MaybeLocal<Value>();
+		}
+
+		CodeCache codeCache(filePath, fileContent);
+		Local<UnboundScript> script;
+		if (!compileScript(this, isolate, source, name, environment.codeCache ? &codeCache : NULL).ToLocal(&script))
+			return MaybeLocal<Value>();
+
+		module = new LoadedModule();
+		module->hasLexicalDeclarations = hasLexicalDeclarations(QString::fromUtf8(fileContent));
+		module->lastModified = lastModified;
+		module->size = fileInfo.size();
+		module->script.Reset(isolate, script);
+		loadedModules.insert(filePath, module);
+	}
+
+	// Repeated load in the same evaluation returns exports of the first one, cyclic load gets undefined
+	if (module->generation == runGeneration) {
+		if (module->isRunning)
+			return handle_scope.Escape(Undefined(isolate));
+		return handle_scope.Escape(Local<Value>::New(isolate, module->exports));
+	}
+
+	TryCatch tryCatch(isolate);
+	Local<Context> context = isolate->GetCurrentContext();
+	Local<Script> script = Local<UnboundScript>::New(isolate, module->script)->BindToCurrentContext();
+
+	module->generation = runGeneration;
+	module->isRunning = true;
+	if (module->hasLexicalDeclarations)
+		isPersistentContextDirty = true;
+	Local<Value> exports;
+	bool isLoaded = script->Run(context).ToLocal(&exports);
+	module->isRunning = false;
+
+	if (!isLoaded) {
+		module->generation = -1;
+		appendExceptionReport(&tryCatch);
+		return MaybeLocal<Value>();
+	}
+
+	module->exports.Reset(isolate, exports);
+	return handle_scope.Escape(exports);
+}
+
+QString WorkbenchEngine::resolveOutputFilePath(const QString& fileName)
+{
+	// Scripts write only below scripts directory, absolute paths, drive letters and parent references are rejected
+	QString path = QDir::fromNativeSeparators(fileName);
+	if (path.isEmpty() || QDir::isAbsolutePath(path) || path.startsWith('/') || path.contains(':'))
+		return QString();
+
+	QStringList parts = path.split('/');
+	if (parts.contains("..") || parts.last().isEmpty() || parts.last() == ".")
+		return QString();
+
+	return QDir::cleanPath(environment.scriptLoadPath + path);
+}
+
+bool WorkbenchEngine::writeOutput(const QString& text)
+{
+	if (outputBuffer.isEmpty())
+		outputTimer.restart();
+
+	outputBuffer.append(text);
+	isOutputWritten = true;
+
+	if (outputBuffer.size() >= OutputFlushSize || outputTimer.elapsed() >= OutputFlushInterval)
+		return flushOutput();
+	return true;
+}
+
+bool WorkbenchEngine::flushOutput()
+{
+	if (outputBuffer.isEmpty())
+		return true;
+
+	bool isWritten = true;
+	if (outputFile != NULL) {
+		QByteArray data = outputBuffer.toUtf8();
+		isWritten = outputFile->write(data) == data.size();
+	}
+	else if (outputSink != NULL) {
+		isWritten = outputSink->write(outputBuffer);
+	}
+	else {
+		collectedOutput.append(outputBuffer);
+	}
+
+	outputBuffer.clear();
+	return isWritten;
+}
+
+bool WorkbenchEngine::redirectOutput(const QString& filePath)
+{
+	if (!finishOutput())
+		return false;
+	if (filePath.isEmpty())
+		return true;
+
+	// File written by script is not recreated when result comes from cache
+	isRunCacheable = false;
+	outputFile = new QFile(filePath);
+	if (!outputFile->open(QFile::WriteOnly | QFile::Truncate)) {
+		delete outputFile;
+		outputFile = NULL;
+		return false;
+	}
+	return true;
+}
+
+bool WorkbenchEngine::finishOutput()
+{
+	bool isWritten = flushOutput();
+
+	if (outputFile != NULL) {
+		outputFile->close();
+		delete outputFile;
+		outputFile = NULL;
+	}
+	return isWritten;
+}
+
 void WorkbenchEngine::appendExceptionReport(TryCatch* trycatch)
 {
+	// Termination carries no exception details
+	if (trycatch->HasTerminated())
+		return;
+
 	exceptions.append(buildExceptionReport(trycatch));
 }
 
@@ -128,23 +1098,216 @@ Local<Context> WorkbenchEngine::createGlobalContext(const QString& workspaceText
 	Local<ObjectTemplate> globalObject = ObjectTemplate::New(isolate);
 
 	// Register variable for workspace data
-	globalObject->Set(Utility::toV8String(isolate, environment.workspaceName), Utility::toV8String(isolate, workspaceText));
+	globalObject->Set(Utility::toV8String(isolate, environment.workspaceName), workspaceString.get(isolate, workspaceText));
 
 	// Register global functions
 	globalObject->Set(String::NewFromUtf8(isolate, "load"), FunctionTemplate::New(isolate, loadCallback, External::New(isolate, this)));
 
+	// Modules can't be part of the global template when snapshot already holds their placeholders
+	Local<ObjectTemplate> moduleObject = startupSnapshot->isLoaded() ? ObjectTemplate::New(isolate) : globalObject;
+	registerModules(moduleObject);
+
+	// Create context
+	Local<Context> context = Context::New(isolate, NULL, globalObject);
+
+	if (startupSnapshot->isLoaded() && !attachModules(context, moduleObject))
+		return Local<Context>();
+
+	return handle_scope.Escape(context);
+}
+
+void WorkbenchEngine::registerModules(Local<ObjectTemplate> object)
+{
+	HandleScope handle_scope(isolate);
+
 	// Register file manipulation functions
 	Local<ObjectTemplate> fileObject = ObjectTemplate::New(isolate);
-	fileObject->Set(String::NewFromUtf8(isolate, "read"), FunctionTemplate::New(isolate, readFileCallback, External::New(isolate, this)));
-	globalObject->Set(String::NewFromUtf8(isolate, "File"), fileObject);
+	fileObject->Set(String::NewFromUtf8(isolate, "read"), NativeBinding::callback<readFileCallback>(isolate, "File.read", External::New(isolate, this)));
+	fileObject->Set(String::NewFromUtf8(isolate, "readAsync"), NativeBinding::callback<readFileAsyncCallback>(isolate, "File.readAsync", External::New(isolate, this)));
+	object->Set(String::NewFromUtf8(isolate, "File"), fileObject);
 
 	// Register workbench functions
-	ModuleTools::registerTemplates(isolate, globalObject);
-	ModuleByteArray::registerTemplates(isolate, globalObject);
+	ModuleTools::registerTemplates(isolate, object);
+	ModuleByteArray::registerTemplates(isolate, object);
+	ModuleParallel::registerTemplates(isolate, object, this);
+	ModuleStats::registerTemplates(isolate, object, this);
+	ModuleBench::registerTemplates(isolate, object, environment.bindingProbes);
+	ModuleOutput::registerTemplates(isolate, object, this);
+	ModuleCache::registerTemplates(isolate, object, this);
+	ModuleShared::registerTemplates(isolate, object, this);
+}
 
-	// Create context
-	Local<Context> context = Context::New(isolate, NULL, globalObject);
-	return handle_scope.Escape(context);
+bool WorkbenchEngine::attachModules(Local<Context> context, Local<ObjectTemplate> moduleObject)
+{
+	HandleScope handle_scope(isolate);
+	Context::Scope context_scope(context);
+
+	Local<Object> modules;
+	if (!moduleObject->NewInstance(context).ToLocal(&modules))
+		return false;
+
+	Local<Array> moduleNames;
+	if (!modules->GetOwnPropertyNames(context).ToLocal(&moduleNames))
+		return false;
+
+	Local<Object> global = context->Global();
+	for (uint32_t i = 0; i < moduleNames->Length(); i++) {
+		Local<Value> name = moduleNames->Get(context, i).ToLocalChecked();
+		Local<Object> module = Local<Object>::Cast(modules->Get(context, name).ToLocalChecked());
+
+		// Move everything core library added to the placeholder onto the native module
+		Local<Value> placeholder = global->Get(context, name).ToLocalChecked();
+		if (placeholder->IsObject()) {
+			Local<Object> placeholderObject = Local<Object>::Cast(placeholder);
+			Local<Array> names;
+			if (!placeholderObject->GetOwnPropertyNames(context).ToLocal(&names))
+				return false;
+
+			for (uint32_t j = 0; j < names->Length(); j++) {
+				Local<Value> key = names->Get(context, j).ToLocalChecked();
+				if (!module->Set(context, key, placeholderObject->Get(context, key).ToLocalChecked()).FromMaybe(false))
+					return false;
+			}
+		}
+
+		if (!global->Set(context, name, module).FromMaybe(false))
+			return false;
+	}
+	return true;
+}
+
+bool WorkbenchEngine::initializeContext(Local<Context> context)
+{
+	HandleScope handle_scope(isolate);
+
+	// Wrapped before core library runs so it sees the same functions as scripts
+	Local<Value> wrapper;
+	if (!executeString(this, isolate, String::NewFromUtf8(isolate, nondeterministicWrapper), String::NewFromUtf8(isolate, "nondeterministic.js")).ToLocal(&wrapper) || !wrapper->IsFunction())
+		return false;
+	Local<Function> preventCaching;
+	if (!Function::New(context, preventCachingCallback, External::New(isolate, this)).ToLocal(&preventCaching))
+		return false;
+	Local<Value> wrapperArgument = preventCaching;
+	if (Local<Function>::Cast(wrapper)->Call(context, context->Global(), 1, &wrapperArgument).IsEmpty())
+		return false;
+
+	// Compile and run core library if loaded and not already part of startup snapshot
+	if (!coreLibraryCode.isEmpty() && !startupSnapshot->isLoaded()) {
+		CodeCache codeCache(environment.coreLibraryPath + environment.coreLibraryName, coreLibraryCode.toUtf8());
+		MaybeLocal<Value> coreLibResult = executeString(this, isolate,
+														Utility::toV8String(isolate, coreLibraryCode),
+														Utility::toV8String(isolate, environment.coreLibraryName),
+														environment.codeCache ? &codeCache : NULL);
+		if (coreLibResult.IsEmpty())
+			return false;
+	}
+
+	return true;
+}
+
+bool WorkbenchEngine::rememberGlobals(Local<Context> context)
+{
+	HandleScope handle_scope(isolate);
+
+	// Function is taken before any script runs, scripts can't replace it for later runs
+	Local<Object> global = context->Global();
+	Local<Value> objectConstructor;
+	Local<Value> getOwnPropertyNames;
+	if (!global->Get(context, String::NewFromUtf8(isolate, "Object")).ToLocal(&objectConstructor) || !objectConstructor->IsObject() ||
+		!Local<Object>::Cast(objectConstructor)->Get(context, String::NewFromUtf8(isolate, "getOwnPropertyNames")).ToLocal(&getOwnPropertyNames) ||
+		!getOwnPropertyNames->IsFunction())
+		return false;
+	Local<Function> namesFunction = Local<Function>::Cast(getOwnPropertyNames);
+
+	// Remember globals defined by templates, core library and V8, everything else belongs to user
+	Local<Object> baseline = Object::New(isolate);
+	Local<Array> watched = Array::New(isolate);
+	Local<String> prototypeName = String::NewFromUtf8(isolate, "prototype");
+	Local<Array> names;
+	if (!ownNames(context, namesFunction, global).ToLocal(&names))
+		return false;
+
+	for (uint32_t i = 0; i < names->Length(); i++) {
+		Local<Value> name = names->Get(context, i).ToLocalChecked();
+		Local<Value> value;
+		if (!global->Get(context, name).ToLocal(&value) || !baseline->Set(context, name, value).FromMaybe(false))
+			return false;
+		if (!value->IsObject())
+			continue;
+
+		// Namespaces, built-ins, their prototypes and nested objects like ByteArray.StringFormat are shared by all runs
+		Local<Array> memberNames;
+		Local<Array> descriptors;
+		if (!watchObject(context, namesFunction, Local<Object>::Cast(value), watched, &memberNames, &descriptors))
+			return false;
+
+		for (uint32_t j = 0; j < descriptors->Length(); j++) {
+			Local<Value> member = descriptorField(context, Local<Object>::Cast(descriptors->Get(context, j).ToLocalChecked()), NativeBinding::NameValue);
+			bool isShared = member->IsObject() && (!member->IsFunction() || memberNames->Get(context, j).ToLocalChecked()->StrictEquals(prototypeName));
+			Local<Array> nestedNames;
+			Local<Array> nestedDescriptors;
+			if (isShared && !watchObject(context, namesFunction, Local<Object>::Cast(member), watched, &nestedNames, &nestedDescriptors))
+				return false;
+		}
+	}
+
+	persistentContext.Reset(isolate, context);
+	baselineGlobals.Reset(isolate, baseline);
+	sharedObjects.Reset(isolate, watched);
+	ownPropertyNames.Reset(isolate, namesFunction);
+	return true;
+}
+
+bool WorkbenchEngine::restoreGlobals(Local<Context> context, const QString& workspaceText)
+{
+	HandleScope handle_scope(isolate);
+
+	Local<Object> global = context->Global();
+	Local<Object> baseline = Local<Object>::New(isolate, baselineGlobals);
+	Local<Function> namesFunction = Local<Function>::New(isolate, ownPropertyNames);
+
+	// Remove globals created by previous runs, var, function and legacy const declarations can't be deleted
+	Local<Array> names;
+	if (!ownNames(context, namesFunction, global).ToLocal(&names))
+		return false;
+
+	for (uint32_t i = 0; i < names->Length(); i++) {
+		Local<Value> name = names->Get(context, i).ToLocalChecked();
+		if (!baseline->HasOwnProperty(context, Local<Name>::Cast(name)).FromMaybe(false) && !global->Delete(context, name).FromMaybe(false))
+			return false;
+	}
+
+	// Changes of objects shared by all runs can't be undone
+	Local<Array> watched = Local<Array>::New(isolate, sharedObjects);
+	for (uint32_t i = 0; i + 2 < watched->Length(); i += 3) {
+		if (!isObjectUnchanged(context, namesFunction, Local<Object>::Cast(watched->Get(context, i).ToLocalChecked()),
+							   Local<Array>::Cast(watched->Get(context, i + 1).ToLocalChecked()), Local<Array>::Cast(watched->Get(context, i + 2).ToLocalChecked())))
+			return false;
+	}
+
+	// Put back globals overwritten by previous runs
+	if (!ownNames(context, namesFunction, baseline).ToLocal(&names))
+		return false;
+
+	for (uint32_t i = 0; i < names->Length(); i++) {
+		Local<Value> name = names->Get(context, i).ToLocalChecked();
+		Local<Value> value = baseline->Get(context, name).ToLocalChecked();
+		Local<Value> current;
+		if (!global->Get(context, name).ToLocal(&current) || (!current->SameValue(value) && !global->Set(context, name, value).FromMaybe(false)))
+			return false;
+	}
+
+	global->Set(context, Utility::toV8String(isolate, environment.workspaceName), workspaceString.get(isolate, workspaceText)).FromMaybe(false);
+	return true;
+}
+
+void WorkbenchEngine::releasePersistentContext()
+{
+	persistentContext.Reset();
+	baselineGlobals.Reset();
+	sharedObjects.Reset();
+	ownPropertyNames.Reset();
+	isPersistentContextDirty = false;
 }
 
 QString WorkbenchEngine::buildExceptionReport(TryCatch* trycatch)
@@ -191,6 +1354,17 @@ QString WorkbenchEngine::buildExceptionReport(TryCatch* trycatch)
 	return report;
 }
 
+void heapLimitCallback(Isolate* isolate, GCType type, GCCallbackFlags flags)
+{
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(isolate->GetData(Utility::DataSlotEngine));
+	workbenchEngine->checkHeapUsage();
+}
+
+void preventCachingCallback(const FunctionCallbackInfo<Value>& args)
+{
+	reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value())->preventResultCaching();
+}
+
 void loadCallback(const FunctionCallbackInfo<Value>& args)
 {
 	if (args.Length() < 1)
@@ -205,21 +1379,7 @@ void loadCallback(const FunctionCallbackInfo<Value>& args)
 		return;
 	}
 
-	QFile file(filePath);
-	if (!file.open(QFile::ReadOnly)) {
-		Utility::throwException(args.GetIsolate(), QString("Could not open file: %1").arg(filePath));
-		return;
-	}
-
-	QByteArray fileContent = file.readAll();
-	Local<String> source;
-	bool ok = String::NewFromUtf8(args.GetIsolate(), fileContent.data(), NewStringType::kNormal, fileContent.length()).ToLocal(&source);
-	if (!ok) {
-		Utility::throwException(args.GetIsolate(), QString("File too large: %1").arg(filePath));
-		return;
-	}
-
-	MaybeLocal<Value> result = executeString(workbenchEngine, args.GetIsolate(), source, args[0]);
+	MaybeLocal<Value> result = workbenchEngine->loadModule(filePath, args[0]);
 	if (result.IsEmpty())
 		return;
 
@@ -234,12 +1394,14 @@ void readFileCallback(const FunctionCallbackInfo<Value>& args)
 	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
 	HandleScope handle_scope(args.GetIsolate());
 
-	QString filePath = workbenchEngine->resolveScriptFilePath(Utility::toString(args[0]));
+	QString fileName = Utility::toString(args[0]);
+	QString filePath = workbenchEngine->resolveScriptFilePath(fileName);
 	if (filePath.isEmpty()) {
 		Utility::throwException(args.GetIsolate(), "Invalid file parameter");
 		return;
 	}
 
+	workbenchEngine->addReadFile(filePath);
 	QFile file(filePath);
 	if (!file.open(QFile::ReadOnly)) {
 		Utility::throwException(args.GetIsolate(), QString("Could not open file: %1").arg(filePath));
@@ -247,27 +1409,106 @@ void readFileCallback(const FunctionCallbackInfo<Value>& args)
 	}
 
 	QByteArray fileContent = file.readAll();
+	NativeStatistics::addBytes(args.GetIsolate(), fileName.size() * sizeof(QChar), fileContent.size());
 	args.GetReturnValue().Set(ModuleByteArray::wrapByteArray(args.GetIsolate(), fileContent));
 }
 
-MaybeLocal<Value> executeString(WorkbenchEngine* workbenchEngine, Isolate* isolate, Local<String> source, Local<Value> name)
+// File is opened and read on pool thread
+class ReadFileTask : public AsyncTasks::Task
+{
+public:
+	ReadFileTask(const QString& path) : filePath(path) {}
+
+	virtual bool run(QString* errorMessage)
+	{
+		QFile file(filePath);
+		if (!file.open(QFile::ReadOnly)) {
+			*errorMessage = QString("Could not open file: %1").arg(filePath);
+			return false;
+		}
+
+		fileContent = file.readAll();
+		return true;
+	}
+
+	virtual Local<Value> result(Isolate* isolate)
+	{
+		return ModuleByteArray::wrapByteArray(isolate, fileContent);
+	}
+
+private:
+	QString filePath;
+	QByteArray fileContent;
+};
+
+void readFileAsyncCallback(const FunctionCallbackInfo<Value>& args)
+{
+	if (args.Length() < 1)
+		return;
+
+	WorkbenchEngine* workbenchEngine = reinterpret_cast<WorkbenchEngine*>(Local<External>::Cast(args.Data())->Value());
+	HandleScope handle_scope(args.GetIsolate());
+
+	// Path is resolved up front, invalid name fails synchronously like File.read, content isn't known before the promise settles
+	QString fileName = Utility::toString(args[0]);
+	NativeStatistics::addBytes(args.GetIsolate(), fileName.size() * sizeof(QChar), 0);
+	QString filePath = workbenchEngine->resolveScriptFilePath(fileName);
+	if (filePath.isEmpty()) {
+		Utility::throwException(args.GetIsolate(), "Invalid file parameter");
+		return;
+	}
+
+	workbenchEngine->addReadFile(filePath);
+	Local<Promise> promise = workbenchEngine->asyncTasks()->start(args.GetIsolate(), new ReadFileTask(filePath));
+	if (!promise.IsEmpty())
+		args.GetReturnValue().Set(promise);
+}
+
+MaybeLocal<Value> executeString(WorkbenchEngine* workbenchEngine, Isolate* isolate, Local<String> source, Local<Value> name, const CodeCache* codeCache, int lineOffset)
 {
 	EscapableHandleScope handle_scope(isolate);
 	TryCatch tryCatch(isolate);
-	ScriptOrigin origin(name);
 	Local<Context> context(isolate->GetCurrentContext());
 
-	Local<Script> script;
-	if (!Script::Compile(context, source, &origin).ToLocal(&script)) {
-		workbenchEngine->appendExceptionReport(&tryCatch);
+	Local<UnboundScript> unboundScript;
+	if (!compileScript(workbenchEngine, isolate, source, name, codeCache, lineOffset).ToLocal(&unboundScript))
 		return MaybeLocal<Value>();
-	}
 
 	Local<Value> result;
-	if (!script->Run(context).ToLocal(&result)) {
+	if (!unboundScript->BindToCurrentContext()->Run(context).ToLocal(&result)) {
 		workbenchEngine->appendExceptionReport(&tryCatch);
 		return MaybeLocal<Value>();
 	}
 
 	return handle_scope.Escape(result);
 }
+
+MaybeLocal<UnboundScript> compileScript(WorkbenchEngine* workbenchEngine, Isolate* isolate, Local<String> source, Local<Value> name, const CodeCache* codeCache, int lineOffset)
+{
+	EscapableHandleScope handle_scope(isolate);
+	TryCatch tryCatch(isolate);
+	ScriptOrigin origin(name, Integer::New(isolate, lineOffset));
+
+	// Consume cached code when available, otherwise produce it for next run
+	ScriptCompiler::CompileOptions options = ScriptCompiler::kNoCompileOptions;
+	ScriptCompiler::CachedData* cachedData = NULL;
+	if (codeCache != NULL) {
+		cachedData = codeCache->load();
+		options = (cachedData != NULL) ? ScriptCompiler::kConsumeCodeCache : ScriptCompiler::kProduceCodeCache;
+	}
+
+	ScriptCompiler::Source scriptSource(source, origin, cachedData);
+
+	Local<UnboundScript> script;
+	if (!ScriptCompiler::CompileUnboundScript(isolate, &scriptSource, options).ToLocal(&script)) {
+		workbenchEngine->appendExceptionReport(&tryCatch);
+		return MaybeLocal<UnboundScript>();
+	}
+
+	if (options == ScriptCompiler::kProduceCodeCache)
+		codeCache->store(scriptSource.GetCachedData());
+	else if (options == ScriptCompiler::kConsumeCodeCache && scriptSource.GetCachedData()->rejected)
+		codeCache->remove();
+
+	return handle_scope.Escape(script);
+}
@@ -3,9 +3,27 @@
 
 #include <QString>
 #include <QStringList>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QHash>
+#include <QElapsedTimer>
 #include "include/v8.h"
 #include "ScriptResult.h"
 #include "Environment.h"
+#include "BufferAllocator.h"
+#include "ScriptProfile.h"
+#include "HeapUsage.h"
+#include "OutputSink.h"
+#include "ScriptCell.h"
+#include "WorkspaceString.h"
+
+class StartupSnapshot;
+class WorkerPool;
+class ValueCache;
+class NativeStatistics;
+class AsyncTasks;
+class ResultCache;
+class QFile;
 
 ////////////////////////////////////////////////////////////////////////////////////
 ///
@@ -14,33 +32,179 @@
 ////////////////////////////////////////////////////////////////////////////////////
 class WorkbenchEngine
 {
-	class ArrayBufferAllocator;
+	class Watchdog;
+	struct LoadedModule;
 
 public:
+	enum TerminationReason
+	{
+		TerminationNone,
+		TerminationStop,
+		TerminationTimeout,
+		TerminationHeapLimit,
+	};
+
 	WorkbenchEngine(const Environment& engineEnvironment);
 	~WorkbenchEngine();
 
-	// Run javascript
-	ScriptResult evaluate(const QString& scriptText, const QString& workspaceText = QString());
+	// Initialize V8 for the whole process, called by constructor
+	// Only the first call has effect
+	static void initializeV8(const QString& v8DataPath);
+
+	// Tear down V8, no engine can be created afterwards
+	static void disposeV8();
+
+	// Build startup snapshot with core library of provided environment
+	static bool createStartupSnapshot(const Environment& environment);
+
+	// Run javascript, CPU profile of the run is stored into profile when provided
+	ScriptResult evaluate(const QString& scriptText, const QString& workspaceText = QString(), ScriptProfile* profile = NULL);
+
+	// Run script split into cells in context kept between calls
+	// Leading cells unchanged since last call are skipped, their state is reused
+	// Runtime of each cell in ms is stored into cellTimes, skipped cells get -1
+	ScriptResult evaluateCells(const QList<ScriptCell>& cells, const QString& workspaceText, QVector<qint64>* cellTimes);
+
+	// Drop persistent and cell context, next evaluation starts from clean slate
+	void reset();
+
+	// Stop running script, can be called from any thread
+	// Stop requested while no script runs ends the next run before it executes
+	void terminate(TerminationReason reason = TerminationStop);
+
+	// Drop stop requested after the last run finished
+	void cancelPendingStop();
+
+	// Called after garbage collection, stops script approaching heap limit
+	void checkHeapUsage();
 
 	// Resolve absolute path to provided file
 	// Returns empty string on error
 	QString resolveScriptFilePath(const QString& fileName);
 
+	// Resolve path of file written by script inside scripts directory, file doesn't have to exist
+	// Returns empty string for absolute paths and paths leaving the directory
+	QString resolveOutputFilePath(const QString& fileName);
+
+	// Counters of ArrayBuffer allocator, can be called from any thread
+	BufferAllocator::Statistics allocatorStatistics() const;
+
+	// Current heap statistics including heap spaces
+	HeapUsage heapUsage();
+
+	// Heap statistics recorded at start and end of last evaluate()
+	const HeapUsage& heapUsageBefore() const { return heapBefore; }
+	const HeapUsage& heapUsageAfter() const { return heapAfter; }
+
+	// Write heap snapshot loadable by Chrome DevTools
+	bool writeHeapSnapshot(const QString& filePath);
+
+	// Pool of engines for parallel execution, created on first use
+	// Returns NULL when parallel execution is disabled
+	WorkerPool* workerPool();
+
+	// Store of Cache module, created on first use and kept for engine lifetime
+	ValueCache* valueCache();
+
+	// Thread pool of async natives, created on first use
+	// Tasks started by previous runs are dropped when new run begins
+	AsyncTasks* asyncTasks();
+
+	// Collection of native call counters, counters are cleared at start of every run
+	void setNativeStatisticsEnabled(bool isEnabled);
+
+	// Counters of current or last run, NULL when collection is disabled
+	const NativeStatistics* nativeStatistics() const { return nativeCounters; }
+
+	// Run script even when result cache holds its result, new result still replaces the stored one
+	void setResultCacheBypassed(bool isBypassed) { isResultCacheBypassed = isBypassed; }
+
+	// File read by running script, stored result is used only while file keeps its content
+	void addReadFile(const QString& filePath);
+
+	// Result of running script depends on more than script, workspace and read files, it is not stored
+	void preventResultCaching() { isRunCacheable = false; }
+
+	// Run script file for load(), compiled code is kept for engine lifetime and file is run once per evaluation
+	// Returns value of last statement, repeated calls return the same value
+	v8::MaybeLocal<v8::Value> loadModule(const QString& filePath, v8::Local<v8::Value> name);
+
 	// Append exception details to list of encountered exceptions
 	void appendExceptionReport(v8::TryCatch* trycatch);
 
+	// Receiver of Output chunks, without sink output is prepended to script result
+	// Sink must outlive engine runs, not owned by engine
+	void setOutputSink(OutputSink* sink) { outputSink = sink; }
+
+	// Buffer text written by script, buffer is flushed when large enough or old enough
+	bool writeOutput(const QString& text);
+
+	// Pass buffered output to file or sink
+	bool flushOutput();
+
+	// Send rest of the output of current run into file, empty path restores sink
+	bool redirectOutput(const QString& filePath);
+
 private:
+	bool beginRun();
+	ScriptResult finishRun(ScriptResult result);
+	QByteArray resultCacheKey(const QString& scriptText, const QString& workspaceText) const;
+	ScriptResult run(const QString& scriptText, const QString& workspaceText);
+	ScriptResult runCells(const QList<ScriptCell>& cells, const QString& workspaceText, QVector<qint64>* cellTimes);
+	ScriptResult awaitResult(v8::Local<v8::Context> context, v8::Local<v8::Value> result, const QString& workspaceText);
+	ScriptResult workspaceResult(v8::Local<v8::Context> context, v8::Local<v8::Value> result, const QString& workspaceText);
+	ScriptResult terminationResult(TerminationReason reason) const;
 	v8::Local<v8::Context> createGlobalContext(const QString& workspaceText);
+	void registerModules(v8::Local<v8::ObjectTemplate> object);
+	bool attachModules(v8::Local<v8::Context> context, v8::Local<v8::ObjectTemplate> moduleObject);
+	bool initializeContext(v8::Local<v8::Context> context);
+	bool rememberGlobals(v8::Local<v8::Context> context);
+	bool restoreGlobals(v8::Local<v8::Context> context, const QString& workspaceText);
+	void releasePersistentContext();
 	QString buildExceptionReport(v8::TryCatch* trycatch);
+	ScriptResult createResult(v8::Local<v8::Context> context, v8::Local<v8::Value> value);
+	bool createTable(v8::Local<v8::Context> context, v8::Local<v8::Array> array, QStringList* columns, QList<QVariantList>* rows);
+	bool finishOutput();
 
 private:
-	v8::Platform* platform;
+	static v8::Platform* platform;
 	v8::Isolate* isolate;
-	ArrayBufferAllocator* alocator;
+	BufferAllocator* alocator;
 	QStringList exceptions;
 	QString coreLibraryCode;
 	Environment environment;
+	StartupSnapshot* startupSnapshot;
+	QAtomicInt terminationReason;
+	size_t heapLimit;
+	size_t peakHeapSize;
+	QAtomicPointer<WorkerPool> workers;
+	HeapUsage heapBefore;
+	HeapUsage heapAfter;
+	QHash<QString, LoadedModule*> loadedModules;
+	int runGeneration;
+	v8::Global<v8::Context> persistentContext;
+	v8::Global<v8::Object> baselineGlobals;
+	v8::Global<v8::Array> sharedObjects;
+	v8::Global<v8::Function> ownPropertyNames;
+	bool isPersistentContextDirty;
+	v8::Global<v8::Context> cellContext;
+	QStringList cellSources;
+	QString cellWorkspaceText;
+	WorkspaceString workspaceString;
+	OutputSink* outputSink;
+	QString outputBuffer;
+	QString collectedOutput;
+	QFile* outputFile;
+	QElapsedTimer outputTimer;
+	bool isOutputWritten;
+	ValueCache* cache;
+	NativeStatistics* nativeCounters;
+	QList<NativeStatistics*> retiredCounters;
+	QAtomicPointer<AsyncTasks> tasks;
+	ResultCache* resultCache;
+	bool isResultCacheBypassed;
+	bool isRunCacheable;
+	QStringList readFiles;
 };
 
 #endif // WORKBENCHENGINE_H
@@ -0,0 +1,134 @@
+#include "WorkerPool.h"
+#include <QRunnable>
+#include <QVector>
+#include <QElapsedTimer>
+#include "WorkbenchEngine.h"
+
+
+class WorkerPool::Task : public QRunnable
+{
+public:
+	Task(WorkerPool* workerPool, const QString& script, int inputIndex, Job* poolJob)
+		: pool(workerPool), scriptText(script), index(inputIndex), job(poolJob) {}
+
+	virtual void run()
+	{
+		if (pool->isTerminated.load()) {
+			job->finished(index, ScriptResult::error("Script execution stopped"), 0);
+			return;
+		}
+
+		QString workspaceText;
+		QString errorMessage;
+		if (!job->input(index, &workspaceText, &errorMessage)) {
+			job->finished(index, ScriptResult::error(errorMessage), 0);
+			return;
+		}
+
+		QElapsedTimer timer;
+		timer.start();
+		WorkbenchEngine* engine = pool->acquireEngine();
+		ScriptResult result = engine->evaluate(scriptText, workspaceText);
+		pool->releaseEngine(engine);
+		job->finished(index, result, timer.elapsed());
+	}
+
+private:
+	WorkerPool* pool;
+	QString scriptText;
+	int index;
+	Job* job;
+};
+
+
+// Job of evaluate(), inputs are in memory and results are collected in order
+class WorkerPool::ListJob : public Job
+{
+public:
+	ListJob(const QStringList& inputList) : inputs(inputList), results(inputList.count()) {}
+
+	virtual bool input(int index, QString* workspaceText, QString*)
+	{
+		*workspaceText = inputs.at(index);
+		return true;
+	}
+
+	virtual void finished(int index, const ScriptResult& result, qint64)
+	{
+		results[index] = result;
+	}
+
+	QList<ScriptResult> resultList() const { return results.toList(); }
+
+private:
+	QStringList inputs;
+	QVector<ScriptResult> results;
+};
+
+
+WorkerPool::WorkerPool(const Environment& engineEnvironment, int workerCount)
+{
+	// Workers keep their context between runs, can't start pools of their own and carry no benchmark probes
+	Environment workerEnvironment = engineEnvironment;
+	workerEnvironment.persistentContext = true;
+	workerEnvironment.workerCount = -1;
+	workerEnvironment.bindingProbes = false;
+
+	for (int i = 0; i < qMax(workerCount, 1); i++)
+		engines.append(new WorkbenchEngine(workerEnvironment));
+	idleEngines = engines;
+
+	threadPool.setMaxThreadCount(engines.count());
+}
+
+WorkerPool::~WorkerPool()
+{
+	terminate();
+	threadPool.waitForDone();
+	qDeleteAll(engines);
+}
+
+int WorkerPool::count() const
+{
+	return engines.count();
+}
+
+QList<ScriptResult> WorkerPool::evaluate(const QString& scriptText, const QStringList& inputs)
+{
+	ListJob job(inputs);
+	evaluateEach(scriptText, inputs.count(), &job);
+	return job.resultList();
+}
+
+void WorkerPool::evaluateEach(const QString& scriptText, int inputCount, Job* job)
+{
+	// Idle engines were stopped along with the previous job
+	isTerminated.store(0);
+	foreach (WorkbenchEngine* engine, engines)
+		engine->cancelPendingStop();
+
+	for (int i = 0; i < inputCount; i++)
+		threadPool.start(new Task(this, scriptText, i, job));
+	threadPool.waitForDone();
+}
+
+void WorkerPool::terminate()
+{
+	isTerminated.store(1);
+
+	foreach (WorkbenchEngine* engine, engines)
+		engine->terminate();
+}
+
+WorkbenchEngine* WorkerPool::acquireEngine()
+{
+	// Thread pool never runs more tasks than there are engines
+	QMutexLocker locker(&mutex);
+	return idleEngines.takeLast();
+}
+
+void WorkerPool::releaseEngine(WorkbenchEngine* engine)
+{
+	QMutexLocker locker(&mutex);
+	idleEngines.append(engine);
+}
@@ -0,0 +1,71 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <QList>
+#include <QStringList>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include "ScriptResult.h"
+#include "Environment.h"
+
+class WorkbenchEngine;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Set of workbench engines, each with its own isolate, running one script
+/// over several workspaces in parallel
+///
+////////////////////////////////////////////////////////////////////////////////////
+class WorkerPool
+{
+	class Task;
+	class ListJob;
+
+public:
+	// Supplies inputs of evaluateEach() and receives its results
+	// Methods are called from worker threads, each index only from one thread
+	class Job
+	{
+	public:
+		virtual ~Job() {}
+
+		// Load workspace for input with provided index, returns false on error
+		virtual bool input(int index, QString* workspaceText, QString* errorMessage) = 0;
+
+		// Result of input with provided index, runtime is in ms
+		virtual void finished(int index, const ScriptResult& result, qint64 runtime) = 0;
+	};
+
+	WorkerPool(const Environment& engineEnvironment, int workerCount);
+	~WorkerPool();
+
+	// Number of engines in pool
+	int count() const;
+
+	// Run script once for every input passed as workspace, blocks until all runs finish
+	// Results are in order of inputs
+	QList<ScriptResult> evaluate(const QString& scriptText, const QStringList& inputs);
+
+	// Run script for inputs provided by job, results are reported as soon as they are ready
+	// Blocks until all runs finish
+	void evaluateEach(const QString& scriptText, int inputCount, Job* job);
+
+	// Stop all running scripts, can be called from any thread
+	void terminate();
+
+private:
+	WorkbenchEngine* acquireEngine();
+	void releaseEngine(WorkbenchEngine* engine);
+
+private:
+	QList<WorkbenchEngine*> engines;
+	QList<WorkbenchEngine*> idleEngines;
+	QMutex mutex;
+	QThreadPool threadPool;
+	QAtomicInt isTerminated;
+
+	Q_DISABLE_COPY(WorkerPool)
+};
+
+#endif // WORKERPOOL_H
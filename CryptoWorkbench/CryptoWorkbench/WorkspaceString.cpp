@@ -0,0 +1,115 @@
+#include "WorkspaceString.h"
+#include "Utility.h"
+
+using namespace v8;
+
+// Shorter texts are cheaper to copy than to track as external strings
+static const int ExternalStringLength = 4096;
+
+// Resources hold implicitly shared copy of the buffer, V8 releases it when string is collected
+class OneByteResource : public String::ExternalOneByteStringResource
+{
+public:
+	OneByteResource(const QByteArray& text) : buffer(text) {}
+
+	virtual const char* data() const { return buffer.constData(); }
+	virtual size_t length() const { return buffer.size(); }
+
+private:
+	QByteArray buffer;
+};
+
+class TwoByteResource : public String::ExternalStringResource
+{
+public:
+	TwoByteResource(const QString& text) : buffer(text) {}
+
+	virtual const uint16_t* data() const { return buffer.utf16(); }
+	virtual size_t length() const { return buffer.size(); }
+
+private:
+	QString buffer;
+};
+
+static bool isLatin1(const QString& text)
+{
+	const ushort* data = text.utf16();
+	const ushort* end = data + text.size();
+	for (; data != end; ++data) {
+		if (*data > 0xff)
+			return false;
+	}
+	return true;
+}
+
+Local<String> WorkspaceString::get(Isolate* isolate, const QString& text)
+{
+	EscapableHandleScope handle_scope(isolate);
+
+	// Same buffer or same content, comparison is much cheaper than new copy
+	if (!string.IsEmpty() && isSame(text))
+		return handle_scope.Escape(Local<String>::New(isolate, string));
+
+	reset();
+	if (text.size() < ExternalStringLength)
+		return handle_scope.Escape(Utility::toV8String(isolate, text));
+
+	// V8 owns resource only when string is created
+	// Only one buffer is kept between runs, resource shares it
+	Local<String> value;
+	if (isLatin1(text)) {
+		QByteArray buffer = text.toLatin1();
+		OneByteResource* resource = new OneByteResource(buffer);
+		if (!String::NewExternalOneByte(isolate, resource).ToLocal(&value)) {
+			delete resource;
+			return handle_scope.Escape(Utility::toV8String(isolate, text));
+		}
+		latin1Text = buffer;
+	}
+	else {
+		TwoByteResource* resource = new TwoByteResource(text);
+		if (!String::NewExternalTwoByte(isolate, resource).ToLocal(&value)) {
+			delete resource;
+			return handle_scope.Escape(Utility::toV8String(isolate, text));
+		}
+		sourceText = text;
+	}
+
+	string.Reset(isolate, value);
+	return handle_scope.Escape(value);
+}
+
+bool WorkspaceString::isCurrent(Isolate* isolate, Local<Value> value) const
+{
+	return !string.IsEmpty() && Local<String>::New(isolate, string) == value;
+}
+
+QString WorkspaceString::text() const
+{
+	return string.IsEmpty() || latin1Text.isNull() ? sourceText : QString::fromLatin1(latin1Text);
+}
+
+void WorkspaceString::reset()
+{
+	string.Reset();
+	sourceText.clear();
+	latin1Text.clear();
+}
+
+bool WorkspaceString::isSame(const QString& text) const
+{
+	if (latin1Text.isNull())
+		return text.constData() == sourceText.constData() || text == sourceText;
+
+	// Compared char by char, no Latin1 copy of new text is made
+	if (text.size() != latin1Text.size())
+		return false;
+
+	const ushort* data = text.utf16();
+	const uchar* latin1 = reinterpret_cast<const uchar*>(latin1Text.constData());
+	for (int i = 0; i < text.size(); i++) {
+		if (data[i] != latin1[i])
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,43 @@
+#ifndef WORKSPACESTRING_H
+#define WORKSPACESTRING_H
+
+#include <QString>
+#include <QByteArray>
+#include "include/v8.h"
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Workspace text handed to javascript as external string without UTF-16 copy.
+/// Latin1 text is kept only in one byte buffer, other text is shared with QString.
+/// String is reused by following runs while the workspace text stays the same.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class WorkspaceString
+{
+public:
+	WorkspaceString() {}
+
+	// Javascript string holding text, small texts are copied into V8 heap
+	v8::Local<v8::String> get(v8::Isolate* isolate, const QString& text);
+
+	// Returns true when value is the string last returned by get()
+	bool isCurrent(v8::Isolate* isolate, v8::Local<v8::Value> value) const;
+
+	// Text of the string last returned by get(), Latin1 text is converted back on every call
+	QString text() const;
+
+	// Release string, must be called before isolate is disposed
+	void reset();
+
+private:
+	WorkspaceString(const WorkspaceString&);
+	WorkspaceString& operator=(const WorkspaceString&);
+
+	bool isSame(const QString& text) const;
+
+	QString sourceText;
+	QByteArray latin1Text;
+	v8::Global<v8::String> string;
+};
+
+#endif // WORKSPACESTRING_H
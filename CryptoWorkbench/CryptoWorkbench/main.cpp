@@ -1,10 +1,17 @@
 #include "CryptoWorkbench.h"
+#include "WorkbenchEngine.h"
 #include <QtWidgets/QApplication>
 
 int main(int argc, char *argv[])
 {
 	QApplication a(argc, argv);
-	CryptoWorkbench w;
-	w.show();
-	return a.exec();
+	int result = 0;
+	{
+		CryptoWorkbench w;
+		w.show();
+		result = a.exec();
+	}
+
+	WorkbenchEngine::disposeV8();
+	return result;
 }
@@ -0,0 +1,229 @@
+#include "DaemonServer.h"
+#include <QRunnable>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include "WorkbenchEngine.h"
+#include "OutputSink.h"
+
+
+// Output chunks go to the client as soon as script writes them
+class DaemonServer::Sink : public OutputSink
+{
+public:
+	Sink(DaemonServer* daemonServer, quint64 connection, const QJsonValue& jobId)
+		: server(daemonServer), connectionId(connection), id(jobId) {}
+
+	virtual bool write(const QString& chunk)
+	{
+		QJsonObject message;
+		message.insert("id", id);
+		message.insert("output", chunk);
+		server->send(connectionId, message);
+		return true;
+	}
+
+private:
+	DaemonServer* server;
+	quint64 connectionId;
+	QJsonValue id;
+};
+
+
+class DaemonServer::Job : public QRunnable
+{
+public:
+	Job(DaemonServer* daemonServer, quint64 connection, const QJsonObject& jobRequest)
+		: server(daemonServer), connectionId(connection), request(jobRequest) {}
+
+	virtual void run()
+	{
+		QJsonValue id = request.value("id");
+		QString formatName = request.value("format").toString();
+		ScriptResult::Format format = ScriptResult::FormatText;
+		if (!formatName.isEmpty() && !ScriptResult::formatFromName(formatName, &format)) {
+			finish(id, ScriptResult::error(QString("Invalid format: %1").arg(formatName)), formatName, 0);
+			return;
+		}
+
+		// Jobs of closed connection are skipped
+		Sink sink(server, connectionId, id);
+		WorkbenchEngine* engine = server->acquireEngine(connectionId);
+		if (engine == NULL)
+			return;
+		engine->setOutputSink(&sink);
+
+		QElapsedTimer timer;
+		timer.start();
+		ScriptResult result = engine->evaluate(request.value("script").toString(), request.value("input").toString());
+		qint64 runtime = timer.nsecsElapsed();
+
+		engine->setOutputSink(NULL);
+		server->releaseEngine(connectionId, engine);
+
+		finish(id, result, formatName, runtime);
+	}
+
+private:
+	void finish(const QJsonValue& id, const ScriptResult& result, const QString& formatName, qint64 runtime)
+	{
+		QJsonObject message;
+		message.insert("id", id);
+		message.insert("valid", result.isValid());
+
+		ScriptResult::Format format;
+		if (result.isValid() && ScriptResult::formatFromName(formatName, &format))
+			message.insert("result", result.render(format));
+		else
+			message.insert("result", result.toJson());
+
+		message.insert("time", runtime / 1000000.0);
+		if (result.isFromCache())
+			message.insert("cached", true);
+		server->send(connectionId, message);
+	}
+
+private:
+	DaemonServer* server;
+	quint64 connectionId;
+	QJsonObject request;
+};
+
+
+DaemonServer::DaemonServer(const Environment& environment, int engineCount, QObject* parent)
+	: QObject(parent), server(new QLocalServer(this)), lastConnectionId(0)
+{
+	// Globals of one job don't leak into the next, every job starts from fresh context
+	// Isolates, startup snapshot and compiled code stay warm between jobs
+	Environment engineEnvironment = environment;
+	engineEnvironment.persistentContext = false;
+
+	for (int i = 0; i < qMax(engineCount, 1); i++) {
+		WorkbenchEngine* engine = new WorkbenchEngine(engineEnvironment);
+		engine->evaluate(QString());
+		engines.append(engine);
+	}
+	idleEngines = engines;
+
+	threadPool.setMaxThreadCount(engines.count());
+	threadPool.setExpiryTimeout(-1);
+
+	connect(server, &QLocalServer::newConnection, this, &DaemonServer::acceptConnection);
+}
+
+DaemonServer::~DaemonServer()
+{
+	server->close();
+	{
+		QMutexLocker locker(&mutex);
+		openConnections.clear();
+	}
+
+	foreach (WorkbenchEngine* engine, engines)
+		engine->terminate();
+	threadPool.waitForDone();
+	qDeleteAll(engines);
+}
+
+bool DaemonServer::listen(const QString& socketPath)
+{
+	// Jobs run with privileges of the daemon, other users can't connect
+	QLocalServer::removeServer(socketPath);
+	server->setSocketOptions(QLocalServer::UserAccessOption);
+	if (!server->listen(socketPath)) {
+		lastErrorMessage = QString("Could not listen on %1: %2").arg(socketPath).arg(server->errorString());
+		return false;
+	}
+	return true;
+}
+
+void DaemonServer::acceptConnection()
+{
+	QLocalSocket* socket;
+	while ((socket = server->nextPendingConnection()) != NULL) {
+		quint64 connectionId = ++lastConnectionId;
+		connections.insert(connectionId, socket);
+		{
+			QMutexLocker locker(&mutex);
+			openConnections.insert(connectionId);
+		}
+
+		connect(socket, &QLocalSocket::readyRead, this, &DaemonServer::readRequests);
+		connect(socket, &QLocalSocket::disconnected, this, &DaemonServer::dropConnection);
+	}
+}
+
+void DaemonServer::readRequests()
+{
+	QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+	quint64 connectionId = connections.key(socket);
+
+	while (socket->canReadLine()) {
+		QJsonDocument document = QJsonDocument::fromJson(socket->readLine());
+		if (!document.isObject() || !document.object().value("script").isString()) {
+			QJsonObject message;
+			message.insert("id", document.object().value("id"));
+			message.insert("valid", false);
+			message.insert("result", QString("Invalid request"));
+			send(connectionId, message);
+			continue;
+		}
+
+		threadPool.start(new Job(this, connectionId, document.object()));
+	}
+}
+
+void DaemonServer::dropConnection()
+{
+	QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+	quint64 connectionId = connections.key(socket);
+
+	connections.remove(connectionId);
+	{
+		// Nobody reads results of the connection, running jobs give their engines back
+		QMutexLocker locker(&mutex);
+		openConnections.remove(connectionId);
+		foreach (WorkbenchEngine* engine, runningEngines.values(connectionId))
+			engine->terminate();
+	}
+	socket->deleteLater();
+}
+
+void DaemonServer::deliver(quint64 connectionId, const QByteArray& line)
+{
+	QLocalSocket* socket = connections.value(connectionId);
+	if (socket != NULL)
+		socket->write(line);
+}
+
+void DaemonServer::send(quint64 connectionId, const QJsonObject& message)
+{
+	// Sockets live in server thread, jobs pass their lines through event loop
+	QByteArray line = QJsonDocument(message).toJson(QJsonDocument::Compact);
+	line.append('\n');
+	QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection, Q_ARG(quint64, connectionId), Q_ARG(QByteArray, line));
+}
+
+// Returns NULL when connection is already closed
+WorkbenchEngine* DaemonServer::acquireEngine(quint64 connectionId)
+{
+	// Thread pool never runs more jobs than there are engines
+	QMutexLocker locker(&mutex);
+	if (!openConnections.contains(connectionId))
+		return NULL;
+
+	WorkbenchEngine* engine = idleEngines.takeLast();
+	runningEngines.insert(connectionId, engine);
+	return engine;
+}
+
+void DaemonServer::releaseEngine(quint64 connectionId, WorkbenchEngine* engine)
+{
+	// Connection closed after the job finished must not stop the next job of the engine
+	QMutexLocker locker(&mutex);
+	runningEngines.remove(connectionId, engine);
+	engine->cancelPendingStop();
+	idleEngines.append(engine);
+}
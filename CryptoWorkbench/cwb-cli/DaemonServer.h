@@ -0,0 +1,79 @@
+#ifndef DAEMONSERVER_H
+#define DAEMONSERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+#include <QJsonObject>
+#include "Environment.h"
+
+class WorkbenchEngine;
+class QLocalServer;
+class QLocalSocket;
+
+////////////////////////////////////////////////////////////////////////////////////
+///
+/// Serves script jobs over local socket on pool of engines kept warm between jobs.
+///
+/// Every request and response is one line of compact JSON. Request holds
+/// "script", optional "input" used as workspace, optional "format" (text, hex,
+/// csv or json) and optional "id" copied into responses. Requests of one
+/// connection may run in parallel. Output chunks are sent as {"id", "output"}
+/// while script runs, the job ends with {"id", "valid", "result", "time"} where
+/// result is rendered in requested format or JSON value when format is missing
+/// and time is runtime in ms. Results taken from result cache add "cached".
+/// Closing the connection stops its running jobs and skips queued ones.
+///
+/// Every job starts from fresh context, but values of Cache module stay in
+/// their engine and values published to Shared stay in the process, so jobs
+/// of all clients see them. Socket accepts only the user running the daemon.
+///
+////////////////////////////////////////////////////////////////////////////////////
+class DaemonServer : public QObject
+{
+	Q_OBJECT
+
+	class Job;
+	class Sink;
+
+public:
+	DaemonServer(const Environment& environment, int engineCount, QObject* parent = NULL);
+	~DaemonServer();
+
+	// Start accepting connections, stale socket left by crashed daemon is removed
+	bool listen(const QString& socketPath);
+
+	// Reason of last listen() failure
+	const QString& errorMessage() const { return lastErrorMessage; }
+
+private slots:
+	void acceptConnection();
+	void readRequests();
+	void dropConnection();
+
+	// Write line to connection, lines of closed connection are dropped
+	void deliver(quint64 connectionId, const QByteArray& line);
+
+private:
+	void send(quint64 connectionId, const QJsonObject& message);
+	WorkbenchEngine* acquireEngine(quint64 connectionId);
+	void releaseEngine(quint64 connectionId, WorkbenchEngine* engine);
+
+private:
+	QLocalServer* server;
+	QList<WorkbenchEngine*> engines;
+	QList<WorkbenchEngine*> idleEngines;
+	QHash<quint64, QLocalSocket*> connections;
+	QSet<quint64> openConnections;
+	QMultiHash<quint64, WorkbenchEngine*> runningEngines;
+	quint64 lastConnectionId;
+	QMutex mutex;
+	QThreadPool threadPool;
+	QString lastErrorMessage;
+};
+
+#endif // DAEMONSERVER_H
@@ -0,0 +1,81 @@
+# Headless runner of workbench scripts, depends on QtCore and QtNetwork for daemon socket
+#
+# qmake V8_DIR=/path/to/v8 V8_LIB_DIR=/path/to/v8/libs && make
+#
+# V8_DIR must contain include/v8.h, by default the headers shipped with the repository are used.
+# V8_LIB_DIR must contain v8, v8_libplatform and v8_libbase libraries built from the same V8 version.
+
+QT = core network
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = cwb-cli
+TEMPLATE = app
+
+ENGINE_DIR = $$PWD/../CryptoWorkbench
+isEmpty(V8_DIR): V8_DIR = $$PWD/../v8
+isEmpty(V8_LIB_DIR): V8_LIB_DIR = $$V8_DIR/lib/linux
+
+INCLUDEPATH += $$ENGINE_DIR $$V8_DIR
+LIBS += -L$$V8_LIB_DIR -lv8 -lv8_libplatform -lv8_libbase
+unix: LIBS += -lpthread -ldl -lrt
+win32: LIBS += -lwinmm
+
+SOURCES += \
+	main.cpp \
+	DaemonServer.cpp \
+	$$ENGINE_DIR/WorkbenchEngine.cpp \
+	$$ENGINE_DIR/WorkerPool.cpp \
+	$$ENGINE_DIR/BatchRunner.cpp \
+	$$ENGINE_DIR/BufferAllocator.cpp \
+	$$ENGINE_DIR/CodeCache.cpp \
+	$$ENGINE_DIR/StartupSnapshot.cpp \
+	$$ENGINE_DIR/ScriptProfile.cpp \
+	$$ENGINE_DIR/ScriptResult.cpp \
+	$$ENGINE_DIR/ScriptCell.cpp \
+	$$ENGINE_DIR/WorkspaceString.cpp \
+	$$ENGINE_DIR/ValueCache.cpp \
+	$$ENGINE_DIR/NativeBinding.cpp \
+	$$ENGINE_DIR/NativeStatistics.cpp \
+	$$ENGINE_DIR/AsyncTasks.cpp \
+	$$ENGINE_DIR/SharedData.cpp \
+	$$ENGINE_DIR/ResultCache.cpp \
+	$$ENGINE_DIR/ModuleTools.cpp \
+	$$ENGINE_DIR/ModuleByteArray.cpp \
+	$$ENGINE_DIR/ModuleParallel.cpp \
+	$$ENGINE_DIR/ModuleStats.cpp \
+	$$ENGINE_DIR/ModuleBench.cpp \
+	$$ENGINE_DIR/ModuleOutput.cpp \
+	$$ENGINE_DIR/ModuleCache.cpp \
+	$$ENGINE_DIR/ModuleShared.cpp
+
+HEADERS += \
+	DaemonServer.h \
+	$$ENGINE_DIR/WorkbenchEngine.h \
+	$$ENGINE_DIR/WorkerPool.h \
+	$$ENGINE_DIR/BatchRunner.h \
+	$$ENGINE_DIR/BufferAllocator.h \
+	$$ENGINE_DIR/CodeCache.h \
+	$$ENGINE_DIR/StartupSnapshot.h \
+	$$ENGINE_DIR/ScriptProfile.h \
+	$$ENGINE_DIR/HeapUsage.h \
+	$$ENGINE_DIR/Environment.h \
+	$$ENGINE_DIR/ScriptResult.h \
+	$$ENGINE_DIR/ScriptCell.h \
+	$$ENGINE_DIR/WorkspaceString.h \
+	$$ENGINE_DIR/ValueCache.h \
+	$$ENGINE_DIR/Utility.h \
+	$$ENGINE_DIR/NativeBinding.h \
+	$$ENGINE_DIR/NativeStatistics.h \
+	$$ENGINE_DIR/AsyncTasks.h \
+	$$ENGINE_DIR/SharedData.h \
+	$$ENGINE_DIR/ResultCache.h \
+	$$ENGINE_DIR/ModuleTools.h \
+	$$ENGINE_DIR/ModuleByteArray.h \
+	$$ENGINE_DIR/ModuleParallel.h \
+	$$ENGINE_DIR/ModuleStats.h \
+	$$ENGINE_DIR/ModuleBench.h \
+	$$ENGINE_DIR/ModuleOutput.h \
+	$$ENGINE_DIR/ModuleCache.h \
+	$$ENGINE_DIR/ModuleShared.h \
+	$$ENGINE_DIR/OutputSink.h
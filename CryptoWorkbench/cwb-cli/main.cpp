@@ -0,0 +1,445 @@
+#include "WorkbenchEngine.h"
+#include "BatchRunner.h"
+#include "DaemonServer.h"
+#include <QThread>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QLocalSocket>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <cstdio>
+
+// Exit codes, script result maps to the first two
+enum ExitCode
+{
+	ExitSuccess = 0,
+	ExitScriptError = 1,
+	ExitUsageError = 2,
+};
+
+// Read whole file, "-" stands for standard input
+static bool readInput(const QString& fileName, QByteArray* data)
+{
+	QFile file(fileName);
+	bool isOpen = (fileName == "-") ? file.open(stdin, QFile::ReadOnly) : file.open(QFile::ReadOnly);
+	if (!isOpen)
+		return false;
+
+	*data = file.readAll();
+	return true;
+}
+
+// Open output file, "-" stands for standard output
+static bool openOutput(QFile* file, const QString& fileName)
+{
+	if (fileName == "-")
+		return file->open(stdout, QFile::WriteOnly);
+
+	file->setFileName(fileName);
+	return file->open(QFile::WriteOnly | QFile::Truncate);
+}
+
+// Streams Output chunks of the script straight into output file
+class FileOutputSink : public OutputSink
+{
+public:
+	FileOutputSink(QFile* outputFile) : file(outputFile) {}
+
+	virtual bool write(const QString& chunk)
+	{
+		QByteArray data = chunk.toUtf8();
+		return file->write(data) == data.size() && file->flush();
+	}
+
+private:
+	QFile* file;
+};
+
+// Parse --format value, raw is reported separately as it isn't a text rendering
+static bool parseFormat(const QString& name, ScriptResult::Format* format, bool* isRaw)
+{
+	*isRaw = (name == "raw");
+	if (*isRaw)
+		return true;
+
+	return ScriptResult::formatFromName(name, format);
+}
+
+static QString directoryPath(const QString& path)
+{
+	QString directory = QDir::fromNativeSeparators(path);
+	if (!directory.isEmpty() && !directory.endsWith('/'))
+		directory.append('/');
+	return directory;
+}
+
+// Run script over every file matching pattern, results go to JSON lines or output directory
+static int runBatch(const Environment& environment, const QString& script, const QString& pattern, const QString& outputPath, bool isJsonLines, int jobCount)
+{
+	QStringList files = BatchRunner::expandGlob(pattern);
+	if (files.isEmpty()) {
+		fprintf(stderr, "No input files: %s\n", qPrintable(pattern));
+		return ExitUsageError;
+	}
+
+	BatchRunner runner(environment, jobCount);
+	if (!runner.run(script, files, outputPath, isJsonLines)) {
+		fprintf(stderr, "%s\n", qPrintable(runner.errorMessage()));
+		return ExitUsageError;
+	}
+
+	const BatchRunner::Summary& summary = runner.summary();
+	fprintf(stderr, "%d files, %d failed, %.1f s, %.1f files/s, %.2f MB/s\n",
+			summary.fileCount, summary.failedCount, summary.elapsed / 1000.0,
+			summary.filesPerSecond(), summary.megabytesPerSecond());
+
+	return summary.failedCount > 0 ? ExitScriptError : ExitSuccess;
+}
+
+// Average engine creation and first run latency over number of iterations
+static void measureStartup(const char* name, const Environment& environment, int iterations)
+{
+	qint64 createTime = 0;
+	qint64 firstRunTime = 0;
+	QElapsedTimer timer;
+
+	for (int i = 0; i < iterations; i++) {
+		timer.start();
+		WorkbenchEngine* engine = new WorkbenchEngine(environment);
+		createTime += timer.nsecsElapsed();
+
+		timer.start();
+		engine->evaluate("");
+		firstRunTime += timer.nsecsElapsed();
+
+		delete engine;
+	}
+
+	printf("%-12s engine start %8.3f ms   first run %8.3f ms\n", name,
+		   createTime / 1e6 / iterations, firstRunTime / 1e6 / iterations);
+}
+
+// Compare startup paths: plain compile of core library, code cache and custom startup snapshot
+static int benchmarkStartup(Environment environment, int iterations)
+{
+	// Stored result of warmup run would replace every measured first run
+	environment.resultCacheDirectory.clear();
+
+	if (!WorkbenchEngine::createStartupSnapshot(environment)) {
+		fprintf(stderr, "Could not build startup snapshot: %s\n", qPrintable(environment.startupSnapshotPath));
+		return ExitUsageError;
+	}
+
+	Environment plain = environment;
+	plain.startupSnapshotPath.clear();
+	plain.codeCache = false;
+
+	Environment cached = plain;
+	cached.codeCache = true;
+
+	// Warm up code cache files and OS file cache
+	measureStartup("warmup", cached, 1);
+
+	measureStartup("plain", plain, iterations);
+	measureStartup("code cache", cached, iterations);
+	measureStartup("snapshot", environment, iterations);
+	return ExitSuccess;
+}
+
+// Call overhead of hand-written native callbacks against NativeBinding wrappers and cost of ported natives
+static const char* bindingBenchmarkScript =
+	"var shortText = 'attack at dawn';\n"
+	"var longText = new Array(1001).join('attack at dawn ');\n"
+	"var data = new ByteArray(longText);\n"
+	"Output.writeLine('Call overhead');\n"
+	"Output.writeLine(Bench.report(Bench.compare({\n"
+	"	'legacy short': function() { Bench.callLegacy(shortText, 6); },\n"
+	"	'bound short': function() { Bench.callBound(shortText, 6); },\n"
+	"	'legacy long': function() { Bench.callLegacy(longText, 6); },\n"
+	"	'bound long': function() { Bench.callBound(longText, 6); }\n"
+	"}, { iterations: ITERATIONS })));\n"
+	"Output.writeLine('Ported natives');\n"
+	"Output.writeLine(Bench.report(Bench.compare({\n"
+	"	'rotateAlphabet': function() { Tools.rotateAlphabet(shortText, 3); },\n"
+	"	'ByteArray.hex': function() { data.hex(); },\n"
+	"	'ByteArray.base64': function() { data.base64(); },\n"
+	"	'ByteArray.hash': function() { data.hash(Tools.Hash.Sha256); },\n"
+	"	'new ByteArray': function() { new ByteArray(shortText); }\n"
+	"}, { iterations: ITERATIONS })));\n";
+
+// Run binding benchmark in engine carrying call overhead probes, report goes to standard output
+static int benchmarkBinding(Environment environment, int iterations)
+{
+	environment.bindingProbes = true;
+	environment.resultCacheDirectory.clear();
+	environment.currentScriptName = "bindingBench.js";
+
+	QFile outputFile;
+	if (!openOutput(&outputFile, "-"))
+		return ExitUsageError;
+
+	FileOutputSink outputSink(&outputFile);
+	WorkbenchEngine engine(environment);
+	engine.setOutputSink(&outputSink);
+	ScriptResult result = engine.evaluate(QString(bindingBenchmarkScript).replace("ITERATIONS", QString::number(iterations)));
+	if (!result.isValid()) {
+		fprintf(stderr, "%s\n", result.data().toUtf8().constData());
+		return ExitScriptError;
+	}
+	return ExitSuccess;
+}
+
+// Send script to daemon, output chunks are written as they arrive
+static int runClient(const QString& socketPath, const QString& script, const QString& workspace, const QString& formatName, QFile* outputFile)
+{
+	QLocalSocket socket;
+	socket.connectToServer(socketPath);
+	if (!socket.waitForConnected()) {
+		fprintf(stderr, "Could not connect to daemon: %s\n", qPrintable(socketPath));
+		return ExitUsageError;
+	}
+
+	QJsonObject request;
+	request.insert("script", script);
+	request.insert("input", workspace);
+	request.insert("format", formatName);
+	QByteArray requestLine = QJsonDocument(request).toJson(QJsonDocument::Compact);
+	requestLine.append('\n');
+	socket.write(requestLine);
+
+	// Daemon ends the job with line holding result
+	while (true) {
+		while (!socket.canReadLine()) {
+			if (!socket.waitForReadyRead(-1)) {
+				fprintf(stderr, "Daemon closed connection\n");
+				return ExitUsageError;
+			}
+		}
+
+		QJsonObject response = QJsonDocument::fromJson(socket.readLine()).object();
+		if (response.contains("output")) {
+			QByteArray chunk = response.value("output").toString().toUtf8();
+			outputFile->write(chunk);
+			outputFile->flush();
+			continue;
+		}
+
+		QByteArray output = response.value("result").toString().toUtf8();
+		if (!response.value("valid").toBool()) {
+			fprintf(stderr, "%s\n", output.constData());
+			return ExitScriptError;
+		}
+
+		if (!output.isEmpty() && !output.endsWith('\n'))
+			output.append('\n');
+		if (outputFile->write(output) != output.size()) {
+			fprintf(stderr, "Could not write output\n");
+			return ExitUsageError;
+		}
+		return ExitSuccess;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("cwb-cli");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Runs CryptoWorkbench script without user interface.\n"
+									 "Exit code is 0 when script succeeds, 1 when it fails and 2 on invalid usage.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("script", "Script file to run.");
+
+	QCommandLineOption inputOption(QStringList() << "i" << "input", "Workspace input file, - for standard input.", "file");
+	QCommandLineOption outputOption(QStringList() << "o" << "output", "Output file, standard output by default.", "file", "-");
+	QCommandLineOption dataOption("data", "Directory with core library.", "directory");
+	QCommandLineOption scriptsOption("scripts", "Directory used by load() and File.read(), script directory by default.", "directory");
+	QCommandLineOption v8DataOption("v8-data", "Directory with V8 natives and snapshot blobs, none by default.", "directory");
+	QCommandLineOption snapshotOption("snapshot", "Startup snapshot with core library.", "file");
+	QCommandLineOption maxHeapOption("max-heap", "Heap limit in MB.", "size", "0");
+	QCommandLineOption timeoutOption("timeout", "Time limit in ms.", "time", "0");
+	QCommandLineOption formatOption("format", "Result format: text, hex, csv, json or raw bytes.", "format", "text");
+	QCommandLineOption noCodeCacheOption("no-code-cache", "Don't store compiled code next to scripts.");
+	QCommandLineOption batchOption("batch", "Run script for every file matching pattern, results are written as JSON lines to output.", "pattern");
+	QCommandLineOption outputDirOption("output-dir", "Write batch result of every file into <name>.out or <name>.err in directory.", "directory");
+	QCommandLineOption cacheDirOption("cache-dir", "Directory keeping values of Cache module between runs.", "directory");
+	QCommandLineOption jobsOption("jobs", "Number of engines running batch or daemon jobs, one per processor core by default.", "count");
+	QCommandLineOption daemonOption("daemon", "Serve jobs on local socket with engines kept warm between jobs, script is not used.", "socket");
+	QCommandLineOption connectOption("connect", "Run script on daemon listening on local socket.", "socket");
+	QCommandLineOption resultCacheOption("result-cache", "Directory with results of earlier runs, identical run over unchanged files returns stored result.", "directory");
+	QCommandLineOption refreshOption("refresh", "Run script even when result cache holds its result, new result replaces the stored one.");
+	QCommandLineOption buildSnapshotOption("build-snapshot", "Build startup snapshot given by --snapshot from core library, script is not used.");
+	QCommandLineOption benchmarkBindingOption("benchmark-binding", "Compare call overhead of hand-written and generated natives, script is not used.", "iterations");
+	QCommandLineOption benchmarkStartupOption("benchmark-startup", "Compare engine startup with plain compile, code cache and snapshot given by --snapshot, script is not used.", "iterations");
+	parser.addOption(inputOption);
+	parser.addOption(outputOption);
+	parser.addOption(dataOption);
+	parser.addOption(scriptsOption);
+	parser.addOption(v8DataOption);
+	parser.addOption(snapshotOption);
+	parser.addOption(maxHeapOption);
+	parser.addOption(timeoutOption);
+	parser.addOption(formatOption);
+	parser.addOption(noCodeCacheOption);
+	parser.addOption(batchOption);
+	parser.addOption(outputDirOption);
+	parser.addOption(jobsOption);
+	parser.addOption(cacheDirOption);
+	parser.addOption(daemonOption);
+	parser.addOption(connectOption);
+	parser.addOption(resultCacheOption);
+	parser.addOption(refreshOption);
+	parser.addOption(buildSnapshotOption);
+	parser.addOption(benchmarkStartupOption);
+	parser.addOption(benchmarkBindingOption);
+	parser.process(a);
+
+	// Defaults match layout of the repository, data directory lies next to application directory
+	QString applicationPath = directoryPath(QCoreApplication::applicationDirPath());
+
+	Environment environment;
+	environment.coreLibraryName = "corelib.js";
+	environment.coreLibraryPath = parser.isSet(dataOption) ? directoryPath(parser.value(dataOption)) : applicationPath + "../data/";
+	environment.workspaceName = "workspace";
+	environment.v8DataPath = directoryPath(parser.value(v8DataOption));
+	environment.startupSnapshotPath = parser.value(snapshotOption);
+	environment.codeCache = !parser.isSet(noCodeCacheOption);
+	environment.maxHeapSize = parser.value(maxHeapOption).toInt();
+	environment.maxRunTime = parser.value(timeoutOption).toInt();
+	environment.cacheDirectory = directoryPath(parser.value(cacheDirOption));
+	environment.resultCacheDirectory = directoryPath(parser.value(resultCacheOption));
+	environment.resultCacheBypassed = parser.isSet(refreshOption);
+
+	// Snapshot tools live here, GUI application has no console for their output
+	if (parser.isSet(buildSnapshotOption) || parser.isSet(benchmarkStartupOption)) {
+		if (environment.startupSnapshotPath.isEmpty()) {
+			fprintf(stderr, "Snapshot file must be given with --snapshot\n");
+			return ExitUsageError;
+		}
+
+		int exitCode = ExitSuccess;
+		if (parser.isSet(buildSnapshotOption)) {
+			if (!WorkbenchEngine::createStartupSnapshot(environment)) {
+				fprintf(stderr, "Could not build startup snapshot: %s\n", qPrintable(environment.startupSnapshotPath));
+				exitCode = ExitUsageError;
+			}
+		}
+		else {
+			exitCode = benchmarkStartup(environment, qMax(1, parser.value(benchmarkStartupOption).toInt()));
+		}
+		WorkbenchEngine::disposeV8();
+		return exitCode;
+	}
+
+	if (parser.isSet(benchmarkBindingOption)) {
+		int exitCode = benchmarkBinding(environment, qMax(1, parser.value(benchmarkBindingOption).toInt()));
+		WorkbenchEngine::disposeV8();
+		return exitCode;
+	}
+
+	// Daemon runs until it is killed, jobs bring their own scripts
+	if (parser.isSet(daemonOption)) {
+		environment.currentScriptName = "daemon";
+		environment.scriptLoadPath = parser.isSet(scriptsOption) ? directoryPath(parser.value(scriptsOption)) : directoryPath(QDir::currentPath());
+
+		int engineCount = parser.isSet(jobsOption) ? parser.value(jobsOption).toInt() : QThread::idealThreadCount();
+		int exitCode = ExitSuccess;
+		{
+			DaemonServer server(environment, engineCount);
+			if (server.listen(parser.value(daemonOption))) {
+				fprintf(stderr, "Listening on %s with %d engines\n", qPrintable(parser.value(daemonOption)), qMax(engineCount, 1));
+				a.exec();
+			}
+			else {
+				fprintf(stderr, "%s\n", qPrintable(server.errorMessage()));
+				exitCode = ExitUsageError;
+			}
+		}
+		WorkbenchEngine::disposeV8();
+		return exitCode;
+	}
+
+	if (parser.positionalArguments().count() != 1) {
+		fprintf(stderr, "%s", qPrintable(parser.helpText()));
+		return ExitUsageError;
+	}
+
+	QString scriptPath = parser.positionalArguments().first();
+	QByteArray script;
+	if (!readInput(scriptPath, &script)) {
+		fprintf(stderr, "Could not read script: %s\n", qPrintable(scriptPath));
+		return ExitUsageError;
+	}
+
+	QByteArray workspace;
+	if (parser.isSet(inputOption) && !readInput(parser.value(inputOption), &workspace)) {
+		fprintf(stderr, "Could not read input: %s\n", qPrintable(parser.value(inputOption)));
+		return ExitUsageError;
+	}
+
+	environment.currentScriptName = QFileInfo(scriptPath).fileName();
+	environment.scriptLoadPath = parser.isSet(scriptsOption) ? directoryPath(parser.value(scriptsOption)) : directoryPath(QFileInfo(scriptPath).absolutePath());
+
+	if (parser.isSet(batchOption)) {
+		int jobCount = parser.isSet(jobsOption) ? parser.value(jobsOption).toInt() : QThread::idealThreadCount();
+		bool isJsonLines = !parser.isSet(outputDirOption);
+		QString outputPath = isJsonLines ? parser.value(outputOption) : parser.value(outputDirOption);
+
+		int exitCode = runBatch(environment, QString::fromUtf8(script), parser.value(batchOption), outputPath, isJsonLines, jobCount);
+		WorkbenchEngine::disposeV8();
+		return exitCode;
+	}
+
+	ScriptResult::Format format = ScriptResult::FormatText;
+	bool isRawOutput = false;
+	if (!parseFormat(parser.value(formatOption), &format, &isRawOutput)) {
+		fprintf(stderr, "Invalid format: %s\n", qPrintable(parser.value(formatOption)));
+		return ExitUsageError;
+	}
+
+	QFile outputFile;
+	if (!openOutput(&outputFile, parser.value(outputOption))) {
+		fprintf(stderr, "Could not write output: %s\n", qPrintable(parser.value(outputOption)));
+		return ExitUsageError;
+	}
+
+	// Client doesn't start V8 at all
+	if (parser.isSet(connectOption)) {
+		if (isRawOutput) {
+			fprintf(stderr, "Raw format is not available with daemon\n");
+			return ExitUsageError;
+		}
+		return runClient(parser.value(connectOption), QString::fromUtf8(script), QString::fromUtf8(workspace), parser.value(formatOption), &outputFile);
+	}
+
+	int exitCode = ExitSuccess;
+	{
+		FileOutputSink outputSink(&outputFile);
+		WorkbenchEngine engine(environment);
+		engine.setOutputSink(&outputSink);
+		ScriptResult result = engine.evaluate(QString::fromUtf8(script), QString::fromUtf8(workspace));
+
+		if (result.isValid()) {
+			QByteArray output = isRawOutput ? result.rawData() : result.render(format).toUtf8();
+			if (!isRawOutput && !output.isEmpty() && !output.endsWith('\n'))
+				output.append('\n');
+
+			if (outputFile.write(output) != output.size()) {
+				fprintf(stderr, "Could not write output: %s\n", qPrintable(parser.value(outputOption)));
+				exitCode = ExitUsageError;
+			}
+		}
+		else {
+			fprintf(stderr, "%s\n", result.data().toUtf8().constData());
+			exitCode = ExitScriptError;
+		}
+	}
+
+	WorkbenchEngine::disposeV8();
+	return exitCode;
+}
@@ -51,6 +51,50 @@ Tools.Hash = Object.freeze({
 	Sha3_512: 10
 });
 
+Parallel.map = function(fn, items) {
+	// Every worker has its own isolate, function is passed as source and items as JSON
+	var chunkCount = Math.min(items.length, Math.max(Parallel.workers(), 1) * 4);
+	var chunkSize = Math.ceil(items.length / chunkCount);
+	var inputs = [];
+	for (var offset = 0; offset < items.length; offset += chunkSize)
+		inputs.push(JSON.stringify({ offset: offset, items: items.slice(offset, offset + chunkSize) }));
+	
+	var script = "(function() {" +
+		" var input = JSON.parse(workspace);" +
+		" var fn = (" + fn.toString() + ");" +
+		" workspace = JSON.stringify(input.items.map(function(item, index) { return fn(item, input.offset + index); }));" +
+		" })();";
+	
+	var results = Parallel.run(script, inputs);
+	var output = [];
+	for (var i = 0; i < results.length; i++)
+		output = output.concat(JSON.parse(results[i]));
+	return output;
+}
+
+Parallel.reduce = function(fn, items, reducer, initialValue) {
+	var results = Parallel.map(fn, items);
+	if (arguments.length > 3)
+		return results.reduce(reducer, initialValue);
+	return results.reduce(reducer);
+}
+
+Bench.report = function(results) {
+	if (!Array.isArray(results))
+		results = [results];
+	
+	var result = "name  median us  min us  p95 us  p99 us  ops/s  MB/s  relative\n";
+	for (var i = 0; i < results.length; i++) {
+		var item = results[i];
+		result += (item.name || "(anonymous)") + "  " +
+			item.median.toFixed(3) + "  " + item.min.toFixed(3) + "  " +
+			item.p95.toFixed(3) + "  " + item.p99.toFixed(3) + "  " +
+			Math.round(item.opsPerSec) + "  " + (item.bytesPerSec / (1024 * 1024)).toFixed(2) + "  " +
+			(item.relative || 1).toFixed(2) + "x\n";
+	}
+	return result;
+}
+
 ByteArray.StringFormat = Object.freeze({
 	Latin1: 0,
 	Utf8: 1,
@@ -1,5 +1,6 @@
 input = "abcdefghijklmnopqrstuvwxyz";
-workspace = "";
 for (var i = 0; i < 26; i++) {
-    workspace += i + '\n' + Tools.rotateAlphabet(input, i) + '\n\n';
+    Output.writeLine(i);
+    Output.writeLine(Tools.rotateAlphabet(input, i));
+    Output.writeLine();
 }
\ No newline at end of file